@@ -0,0 +1,94 @@
+#pragma once
+#include <asio.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/Protocol.hpp"
+#include "common/SpscQueue.hpp"
+
+namespace client::net {
+
+// What the network thread hands to the render thread
+struct NetEvent {
+    enum class Kind : std::uint8_t {
+        Entities, // a decoded StateDelta fragment: the world state for ids [firstId, lastId]
+        Packet    // any other message, as received
+    };
+    Kind kind = Kind::Packet;
+    std::uint32_t snapshotId = 0;
+    std::uint32_t serverTime = 0; // ms, server clock
+    std::uint32_t inputAck = 0;
+    std::uint32_t firstId = 0;
+    std::uint32_t lastId = 0;
+    std::vector<rtype::net::PackedEntity> entities; // sorted by id
+    std::vector<char> packet;                       // header included
+};
+
+// UDP link to the game server, served by its own thread. The thread waits on
+// the socket, so datagrams are read as they arrive whatever the frame rate,
+// and does the wire work there: snapshot fragments are decoded against their
+// baseline, reassembled and acknowledged without waiting for a frame. The
+// render thread only drains the results with poll(). Sends from the render
+// thread are posted to the network thread, which owns the socket.
+class UdpLink {
+public:
+    UdpLink() = default;
+    ~UdpLink();
+    UdpLink(const UdpLink&) = delete;
+    UdpLink& operator=(const UdpLink&) = delete;
+
+    // Resolves the server and starts the thread; throws on resolve/open errors
+    void open(const std::string& host, std::uint16_t port);
+    // Stops the thread once the sends already queued have left
+    void close();
+    bool isOpen() const { return thread_.joinable(); }
+
+    // Render thread: queue one datagram (header included) for the server
+    void send(const void* data, std::size_t size);
+    // Render thread: next event, false when none is pending
+    bool poll(NetEvent& out) { return events_.pop(out); }
+    // Events lost because the render thread did not drain them in time
+    std::size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t kMaxDatagram = 2048;
+    static constexpr std::size_t kMaxSend = 256;
+
+    void doReceive();
+    void handleDatagram(const char* data, std::size_t size);
+    void handleStateFragment(const char* p, std::size_t n);
+    void sendStateAck(std::uint32_t snapshotId);
+    void publish(NetEvent&& ev);
+
+    asio::io_context io_;
+    asio::ip::udp::socket socket_{io_};
+    asio::ip::udp::endpoint server_;
+    asio::ip::udp::endpoint from_;
+    std::array<char, kMaxDatagram> buffer_{};
+    std::thread thread_;
+
+    rtype::common::SpscQueue<NetEvent, 1024> events_;
+    std::atomic<std::size_t> dropped_{0};
+
+    // Network thread only. Decoded snapshots (slot = id % size): the server
+    // encodes deltas against the ones we acknowledge
+    struct Snapshot { std::uint32_t id = 0; std::vector<rtype::net::PackedEntity> entities; };
+    std::array<Snapshot, 32> snapshots_{};
+    std::uint32_t lastSnapshotId_ = 0;  // newest complete snapshot
+    std::uint32_t shownSnapshotId_ = 0; // newest snapshot with at least one fragment published
+    // Fragments of the snapshots being received (slot = id % size)
+    struct Assembly {
+        std::uint32_t id = 0;
+        std::uint8_t count = 0;
+        std::uint32_t received = 0; // bit per fragment
+        std::array<rtype::net::StateDeltaHeader, rtype::net::MaxSnapshotFragments> headers{};
+        std::array<std::vector<char>, rtype::net::MaxSnapshotFragments> records;
+    };
+    std::array<Assembly, 4> assemblies_{};
+};
+
+}
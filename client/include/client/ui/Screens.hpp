@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <array>
 #include <cstdint>
 #include <unordered_map>
 #include <memory>
@@ -8,6 +9,8 @@
 #include <utility>
 #include <random>
 #include <asio.hpp>
+#include "common/Protocol.hpp"
+#include "client/net/UdpLink.hpp"
 
 // ECS Engine (standalone) headers for local singleplayer test
 #include "rt/ecs/Registry.hpp"
@@ -23,6 +26,8 @@
 #include "rt/systems/MovementSystem.hpp"
 #include "rt/systems/AiControlSystem.hpp"
 #include "rt/systems/CollisionSystem.hpp"
+// Server gameplay systems, to predict our own ship in multiplayer
+#include "rt/game/Systems.hpp"
 
 
 namespace client {
@@ -194,7 +199,7 @@ private:
 
     // Check if required sprite assets are available on disk
     bool assetsAvailable() const;
-    // Parse a single UDP datagram payload according to our protocol and update local state
+    // Applies one received message; StateDelta fragments arrive decoded, through applyNetEvent
     void handleNetPacket(const char* data, std::size_t n);
     int _focusedField = 0;
     std::string _statusMessage;
@@ -210,24 +215,98 @@ private:
     // TCP handshake methods
     bool connectTcp();
     void disconnectTcp();
-    // UDP client method for gameplay
+    // UDP link for gameplay, on its own thread
+    client::net::UdpLink _udp;
     void ensureNetSetup();
     void teardownNet();
     void sendDisconnect();
-    void sendInput(std::uint8_t bits);
+    // Newest samples, repeated in every datagram until the server applied them
+    void sendInput();
     void sendLobbyConfig(std::uint8_t difficulty, std::uint8_t baseLives);
     void sendStartMatch();
+    // Applies what the network thread received since the last call
     void pumpNetworkOnce();
+    void applyNetEvent(const client::net::NetEvent& ev);
     bool waitHelloAck(double timeoutSec);
     struct PackedEntity { unsigned id; unsigned char type; float x; float y; float vx; float vy; unsigned rgba; };
-    std::vector<PackedEntity> _entities;
-    // Entity reconciliation buffers: avoid dropping entities on transient packet loss or truncation
-    std::unordered_map<unsigned, PackedEntity> _entityById; // id -> last known entity state
-    std::unordered_map<unsigned, int> _missedById;          // id -> consecutive snapshots missed
-    std::unordered_map<unsigned, double> _lastSeenAt;       // id -> last time seen in a snapshot (seconds)
-    int _missThreshold = 3;                                 // safeguard: remove only if both miss-count and time exceed
-    double _expireSecondsEnemy = 2.0;                       // enemies expire after not seen for this time
-    double _expireSecondsDefault = 1.0;                     // players/bullets/powerups
+    // Remote entities are drawn a little in the past, between two received
+    // states, rather than at the newest one: motion stays smooth at any frame
+    // rate and snapshot rate, and a late snapshot does not freeze anything.
+    struct TimedState { double time = 0.0; float x = 0.f; float y = 0.f; float vx = 0.f; float vy = 0.f; };
+    struct EntityHistory {
+        std::array<TimedState, 8> states{}; // ring, oldest at `head`
+        std::uint8_t head = 0;
+        std::uint8_t count = 0;
+        void push(const TimedState& s);
+        const TimedState& at(std::size_t i) const { return states[(head + i) % states.size()]; }
+    };
+    // Known entities live in one dense table, removed by swapping the last
+    // slot in. The ids and update stamps that snapshot handling scans sit in
+    // their own array; each type keeps the list of its slots, patched as
+    // entities come, go or move, so drawing in type order needs no rebuild.
+    struct SlotKey { unsigned id; std::uint32_t seenIn; }; // seenIn: last range update listing it
+    struct EntitySlot {
+        PackedEntity state;    // drawn state: newest received, positions interpolated each frame
+        EntityHistory history; // recent states, by server time
+        std::uint32_t typePos; // index in _slotsByType[typeList(state.type)]
+    };
+    std::vector<SlotKey> _slotKeys;  // parallel to _slots
+    std::vector<EntitySlot> _slots;
+    std::unordered_map<unsigned, std::uint32_t> _slotById;
+    std::array<std::vector<std::uint32_t>, 5> _slotsByType; // by EntityType, 0 for unknown types
+    std::uint32_t _rangeStamp = 0;
+    static std::size_t typeList(unsigned char type) { return type < 5 ? type : 0; }
+    EntitySlot* findEntity(unsigned id);
+    // The entity's slot, and whether it was just added (like try_emplace)
+    std::pair<EntitySlot*, bool> upsertEntity(const PackedEntity& e);
+    void removeSlot(std::uint32_t slot);
+    void removeEntity(unsigned id);
+    void clearEntities();
+    // Calls f(state) for every entity, in drawing order: players, bullets, powerups, enemies
+    template <typename F>
+    void forEachEntity(F&& f) {
+        for (std::size_t type : {1u, 3u, 4u, 2u})
+            for (std::uint32_t slot : _slotsByType[type]) f(_slots[slot].state);
+    }
+    // Server clock mapping: local time (GetTime) minus server time, from the fastest snapshots seen
+    double _serverClockOffset = 0.0;
+    bool _haveServerClock = false;
+    double _lastServerTime = 0.0;     // newest snapshot time (server clock, seconds)
+    double _snapshotInterval = 0.05;  // smoothed gap between snapshots
+    // Render delay behind the newest snapshot: two snapshot intervals, so one can be lost
+    double interpolationDelay() const;
+    // Sets every entity's drawn position for `renderTime` (server clock) from its history
+    void interpolateEntities(double renderTime);
+    // Our own ship is not interpolated but predicted. Input is sampled once
+    // per input tick, and each sample moves the ship right away with the
+    // server's InputSystem; the server applies the same samples, one per tick.
+    // Snapshots carry the newest sample the server applied: the ship restarts
+    // from its position there and replays the samples after it, and the
+    // difference with what was drawn is blended out over a few frames.
+    struct PendingInput { std::uint32_t sequence; std::uint8_t bits; };
+    std::vector<PendingInput> _pendingInputs; // sampled, not applied by the server yet; oldest first
+    std::uint32_t _inputSeq = 0;  // newest sample
+    std::uint8_t _inputBits = 0;  // its bits
+    float _inputAccum = 0.f;      // time towards the next sample
+    std::unique_ptr<rt::ecs::Registry> _predWorld; // holds our ship only
+    rt::ecs::Entity _predShip = 0;
+    rt::game::InputSystem _predInput;
+    bool _havePrediction = false;
+    float _predErrX = 0.f; // correction not blended out yet
+    float _predErrY = 0.f;
+    float _predPrevX = 0.f; // ship before the newest sample: drawn in between
+    float _predPrevY = 0.f;
+    // Takes a sample of `bits` for every input tick elapsed over `dt`, moving the ship
+    void sampleInput(std::uint8_t bits, float dt);
+    // Draws our ship where the samples so far put it
+    void placeLocalShip();
+    void reconcileLocalShip(float x, float y, std::uint32_t inputAck);
+    void stepLocalShip(std::uint8_t bits, float dt);
+    client::net::NetEvent _netEvent; // reused by pumpNetworkOnce
+    void showEntities(std::uint32_t firstId, std::uint32_t lastId, double serverTime,
+                      const std::vector<rtype::net::PackedEntity>& range);
+    void trackServerClock(double serverTime);
+    void resetSnapshots();
     double _lastSend = 0.0;
     bool _serverReturnToMenu = false;
     // --- spritesheet handling ---
@@ -275,6 +354,7 @@ private:
     double _beamEndTime = 0.0;
     float _beamX = 0.0f;        // origin X at release
     float _beamY = 0.0f;        // center Y at release
+    float _beamLength = 0.0f;   // from server Beam events (0 = to the screen edge)
     float _beamThickness = 0.0f; // computed from charge duration
 
     // --- Shot mode toggle (Normal vs Charge), switched with Ctrl key ---
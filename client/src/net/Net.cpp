@@ -1,6 +1,7 @@
 #include "Screens.hpp"
 #include <asio.hpp>
 #include <vector>
+#include <cstddef>
 #include <cstring>
 #include <array>
 #include <thread>
@@ -9,14 +10,6 @@
 
 namespace client { namespace ui {
 
-namespace {
-    struct UdpClientGlobals {
-        std::unique_ptr<asio::io_context> io;
-        std::unique_ptr<asio::ip::udp::socket> sock;
-        asio::ip::udp::endpoint server;
-    } g;
-}
-
 bool Screens::connectTcp() {
     try {
         _tcpIo = std::make_unique<asio::io_context>();
@@ -85,25 +78,18 @@ void Screens::leaveSession() {
     teardownNet();
     disconnectTcp();
     _connected = false;
-    _entities.clear();
-    _entityById.clear();
-    _missedById.clear();
-    _lastSeenAt.clear();
+    clearEntities();
+    resetSnapshots();
     _serverReturnToMenu = false;
 }
 
 void Screens::ensureNetSetup() {
-    if (g.io) return;
+    if (_udp.isOpen()) return;
     if (_udpPort == 0) {
         logMessage("UDP port not set - TCP handshake may have failed", "ERROR");
         return;
     }
-    g.io = std::make_unique<asio::io_context>();
-    g.sock = std::make_unique<asio::ip::udp::socket>(*g.io);
-    g.sock->open(asio::ip::udp::v4());
-    asio::ip::udp::resolver resolver(*g.io);
-    g.server = *resolver.resolve(asio::ip::udp::v4(), _serverAddr, std::to_string(_udpPort)).begin();
-    g.sock->non_blocking(true);
+    _udp.open(_serverAddr, _udpPort);
     _serverReturnToMenu = false;
 
    // Send UDP Hello with username to bind
@@ -114,51 +100,59 @@ void Screens::ensureNetSetup() {
     std::vector<char> out(sizeof(rtype::net::Header) + _username.size());
     std::memcpy(out.data(), &hdr, sizeof(hdr));
     if (!_username.empty()) std::memcpy(out.data() + sizeof(hdr), _username.data(), _username.size());
-    g.sock->send_to(asio::buffer(out), g.server);
+    _udp.send(out.data(), out.size());
 }
 
 void Screens::sendDisconnect() {
-    if (!g.sock) return;
+    if (!_udp.isOpen()) return;
     rtype::net::Header hdr{};
     hdr.version = rtype::net::ProtocolVersion;
     hdr.type = rtype::net::MsgType::Disconnect;
     hdr.size = 0;
     std::array<char, sizeof(rtype::net::Header)> buf{};
     std::memcpy(buf.data(), &hdr, sizeof(hdr));
-    asio::error_code ec;
-    g.sock->send_to(asio::buffer(buf), g.server, 0, ec);
+    _udp.send(buf.data(), buf.size());
 }
 
 void Screens::teardownNet() {
-    if (g.sock && g.sock->is_open()) {
+    if (_udp.isOpen()) {
         sendDisconnect();
-        asio::error_code ec; g.sock->close(ec);
+        _udp.close();
     }
-    g.sock.reset();
-    g.io.reset();
     _spriteRowById.clear();
     _nextSpriteRow = 0;
-    _entities.clear();
-    _entityById.clear();
-    _missedById.clear();
-    _lastSeenAt.clear();
+    clearEntities();
+    resetSnapshots();
 }
 
-void Screens::sendInput(std::uint8_t bits) {
-    if (!g.sock) return;
+void Screens::sendInput() {
+    if (!_udp.isOpen() || _inputSeq == 0) return;
+    rtype::net::InputPacket ip{};
+    ip.sequence = _inputSeq;
+    if (_pendingInputs.empty()) {
+        // All applied: the newest one again keeps the link alive, the server ignores it
+        ip.count = 1;
+        ip.bits[0] = _inputBits;
+    } else {
+        // Pending samples have consecutive sequences ending at _inputSeq
+        const std::size_t count = std::min(_pendingInputs.size(), rtype::net::MaxRedundantInputs);
+        ip.count = static_cast<std::uint8_t>(count);
+        for (std::size_t k = 0; k < count; ++k)
+            ip.bits[k] = _pendingInputs[_pendingInputs.size() - count + k].bits;
+    }
+    const std::size_t size = offsetof(rtype::net::InputPacket, bits) + ip.count;
     rtype::net::Header hdr{};
     hdr.version = rtype::net::ProtocolVersion;
     hdr.type = rtype::net::MsgType::Input;
-    rtype::net::InputPacket ip{}; ip.sequence = 0; ip.bits = bits;
-    hdr.size = sizeof(ip);
+    hdr.size = static_cast<std::uint16_t>(size);
     std::array<char, sizeof(hdr) + sizeof(ip)> buf{};
     std::memcpy(buf.data(), &hdr, sizeof(hdr));
-    std::memcpy(buf.data() + sizeof(hdr), &ip, sizeof(ip));
-    g.sock->send_to(asio::buffer(buf), g.server);
+    std::memcpy(buf.data() + sizeof(hdr), &ip, size);
+    _udp.send(buf.data(), sizeof(hdr) + size);
 }
 
 void Screens::sendLobbyConfig(std::uint8_t difficulty, std::uint8_t baseLives) {
-    if (!g.sock) return;
+    if (!_udp.isOpen()) return;
     rtype::net::Header hdr{};
     hdr.version = rtype::net::ProtocolVersion;
     hdr.type = rtype::net::MsgType::LobbyConfig;
@@ -167,54 +161,50 @@ void Screens::sendLobbyConfig(std::uint8_t difficulty, std::uint8_t baseLives) {
     std::array<char, sizeof(hdr) + sizeof(p)> buf{};
     std::memcpy(buf.data(), &hdr, sizeof(hdr));
     std::memcpy(buf.data() + sizeof(hdr), &p, sizeof(p));
-    g.sock->send_to(asio::buffer(buf), g.server);
+    _udp.send(buf.data(), buf.size());
 }
 
 void Screens::sendStartMatch() {
-    if (!g.sock) return;
+    if (!_udp.isOpen()) return;
     rtype::net::Header hdr{};
     hdr.version = rtype::net::ProtocolVersion;
     hdr.type = rtype::net::MsgType::StartMatch;
     hdr.size = 0;
     std::array<char, sizeof(rtype::net::Header)> buf{};
     std::memcpy(buf.data(), &hdr, sizeof(hdr));
-    g.sock->send_to(asio::buffer(buf), g.server);
+    _udp.send(buf.data(), buf.size());
+}
+
+void Screens::resetSnapshots() {
+    clearEntities();
+    _haveServerClock = false;
+    _lastServerTime = 0.0;
+    _snapshotInterval = 0.05;
+    _pendingInputs.clear();
+    _inputSeq = 0;
+    _inputBits = 0;
+    _inputAccum = 0.f;
+    _havePrediction = false;
+    _predErrX = _predErrY = 0.f;
 }
 
 void Screens::pumpNetworkOnce() {
-    if (!g.sock) return;
-    for (int i = 0; i < 8; ++i) {
-        asio::ip::udp::endpoint from;
-        std::array<char, 8192> in{};
-        asio::error_code ec;
-        std::size_t n = g.sock->receive_from(asio::buffer(in), from, 0, ec);
-        if (ec == asio::error::would_block) break;
-        if (ec || n < sizeof(rtype::net::Header)) break;
-        handleNetPacket(in.data(), n);
-    }
+    // Everything already decoded, however much arrived during the last frame
+    while (_udp.poll(_netEvent)) applyNetEvent(_netEvent);
 }
 
 bool Screens::waitHelloAck(double timeoutSec) {
     double start = GetTime();
     while (GetTime() - start < timeoutSec) {
-        asio::ip::udp::endpoint from;
-        std::array<char, 8192> in{};
-        asio::error_code ec;
-        std::size_t n = g.sock->receive_from(asio::buffer(in), from, 0, ec);
-        if (!ec && n >= sizeof(rtype::net::Header)) {
-            auto* rh = reinterpret_cast<rtype::net::Header*>(in.data());
-            if (rh->version == rtype::net::ProtocolVersion) {
-                if (rh->type == rtype::net::MsgType::Roster ||
-                    rh->type == rtype::net::MsgType::State ||
-                    rh->type == rtype::net::MsgType::LivesUpdate ||
-                    rh->type == rtype::net::MsgType::ScoreUpdate) {
-                    handleNetPacket(in.data(), n);
-                    return true;
-                }
-                handleNetPacket(in.data(), n);
-            }
-        } else if (ec && ec != asio::error::would_block && ec != asio::error::try_again) {
-            logMessage(std::string("Receive error: ") + ec.message(), "ERROR");
+        while (_udp.poll(_netEvent)) {
+            applyNetEvent(_netEvent);
+            if (_netEvent.kind == client::net::NetEvent::Kind::Entities) return true;
+            rtype::net::Header rh{};
+            std::memcpy(&rh, _netEvent.packet.data(), sizeof(rh));
+            if (rh.type == rtype::net::MsgType::Roster ||
+                rh.type == rtype::net::MsgType::LivesUpdate ||
+                rh.type == rtype::net::MsgType::ScoreUpdate)
+                return true;
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(5));
     }
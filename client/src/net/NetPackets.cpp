@@ -1,93 +1,256 @@
 #include "Screens.hpp"
 #include "common/Protocol.hpp"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <limits>
 #include <chrono>
 #include <iostream>
 #include <unordered_set>
 
 namespace client { namespace ui {
 
+void Screens::trackServerClock(double serverTime) {
+    // The least delayed datagram gives the best offset; later ones pull it up
+    // slowly, so a route that got slower is followed without jitter
+    const double offset = GetTime() - serverTime;
+    if (!_haveServerClock || offset < _serverClockOffset) _serverClockOffset = offset;
+    else _serverClockOffset += (offset - _serverClockOffset) * 0.01;
+    if (_haveServerClock && serverTime > _lastServerTime)
+        _snapshotInterval += (std::min(serverTime - _lastServerTime, 0.5) - _snapshotInterval) * 0.1;
+    if (!_haveServerClock || serverTime > _lastServerTime) _lastServerTime = serverTime;
+    _haveServerClock = true;
+}
+
+void Screens::EntityHistory::push(const TimedState& s) {
+    if (count > 0) {
+        TimedState& newest = states[(head + count - 1) % states.size()];
+        if (s.time < newest.time) return; // older than what we have
+        if (s.time == newest.time) { newest = s; return; }
+    }
+    if (count < states.size()) {
+        states[(head + count) % states.size()] = s;
+        ++count;
+    } else {
+        states[head] = s;
+        head = static_cast<std::uint8_t>((head + 1) % states.size());
+    }
+}
+
+double Screens::interpolationDelay() const {
+    return std::clamp(2.0 * _snapshotInterval, 0.05, 0.3);
+}
+
+void Screens::interpolateEntities(double renderTime) {
+    // Past the newest state, follow the velocity for a short while only
+    constexpr double kMaxExtrapolation = 0.1;
+    for (auto& slot : _slots) {
+        const EntityHistory& h = slot.history;
+        if (h.count == 0) continue;
+        PackedEntity& e = slot.state;
+        const TimedState& oldest = h.at(0);
+        const TimedState& newest = h.at(h.count - 1);
+        if (renderTime <= oldest.time) {
+            e.x = oldest.x;
+            e.y = oldest.y;
+        } else if (renderTime >= newest.time) {
+            const auto ahead = static_cast<float>(std::min(renderTime - newest.time, kMaxExtrapolation));
+            e.x = newest.x + newest.vx * ahead;
+            e.y = newest.y + newest.vy * ahead;
+        } else {
+            for (std::size_t i = 1; i < h.count; ++i) {
+                const TimedState& b = h.at(i);
+                if (b.time < renderTime) continue;
+                const TimedState& a = h.at(i - 1);
+                const auto t = static_cast<float>((renderTime - a.time) / (b.time - a.time));
+                e.x = a.x + (b.x - a.x) * t;
+                e.y = a.y + (b.y - a.y) * t;
+                break;
+            }
+        }
+    }
+}
+
+void Screens::stepLocalShip(std::uint8_t bits, float dt) {
+    if (dt <= 0.f) return;
+    _predWorld->get<rt::game::PlayerInput>(_predShip)->bits = bits;
+    _predInput.update(*_predWorld, dt);
+}
+
+void Screens::sampleInput(std::uint8_t bits, float dt) {
+    const auto tick = static_cast<float>(1.0 / rtype::net::InputTickRate);
+    // After a stall, a few samples catch up; the server fills larger gaps itself
+    _inputAccum = std::min(_inputAccum + dt, tick * rtype::net::MaxRedundantInputs);
+    while (_inputAccum >= tick) {
+        _inputAccum -= tick;
+        _inputBits = bits;
+        // Unacknowledged for a long while (no snapshot with our ship): forget the oldest
+        if (_pendingInputs.size() >= 128) _pendingInputs.erase(_pendingInputs.begin());
+        _pendingInputs.push_back({++_inputSeq, bits});
+        if (_havePrediction) {
+            const auto* t = _predWorld->get<rt::game::Transform>(_predShip);
+            _predPrevX = t->x;
+            _predPrevY = t->y;
+            stepLocalShip(bits, tick);
+        }
+    }
+    const float decay = std::exp(-10.f * dt);
+    _predErrX *= decay;
+    _predErrY *= decay;
+}
+
+void Screens::placeLocalShip() {
+    if (!_havePrediction) return;
+    EntitySlot* self = findEntity(_selfId);
+    if (!self || self->state.type != 1) return;
+    const auto* t = _predWorld->get<rt::game::Transform>(_predShip);
+    const auto alpha = static_cast<float>(_inputAccum * rtype::net::InputTickRate);
+    self->state.x = _predPrevX + (t->x - _predPrevX) * alpha + _predErrX;
+    self->state.y = _predPrevY + (t->y - _predPrevY) * alpha + _predErrY;
+}
+
+void Screens::reconcileLocalShip(float x, float y, std::uint32_t inputAck) {
+    if (!_predWorld) {
+        _predWorld = std::make_unique<rt::ecs::Registry>();
+        _predShip = _predWorld->create();
+        _predWorld->emplace<rt::game::Transform>(_predShip, rt::game::Transform{x, y});
+        _predWorld->emplace<rt::game::PlayerInput>(_predShip, rt::game::PlayerInput{});
+    }
+    _pendingInputs.erase(std::remove_if(_pendingInputs.begin(), _pendingInputs.end(),
+                                        [&](const PendingInput& in) { return in.sequence <= inputAck; }),
+                         _pendingInputs.end());
+    auto* t = _predWorld->get<rt::game::Transform>(_predShip);
+    const float oldX = t->x;
+    const float oldY = t->y;
+    t->x = x;
+    t->y = y;
+    const auto tick = static_cast<float>(1.0 / rtype::net::InputTickRate);
+    for (const auto& in : _pendingInputs) stepLocalShip(in.bits, tick);
+    // The drawn path shifts with the ship; the shift is blended out, unless
+    // it is large (respawn, missed snapshots) and taken at once
+    _predPrevX += t->x - oldX;
+    _predPrevY += t->y - oldY;
+    _predErrX -= t->x - oldX;
+    _predErrY -= t->y - oldY;
+    if (!_havePrediction || _predErrX * _predErrX + _predErrY * _predErrY > 64.f * 64.f) {
+        _predErrX = _predErrY = 0.f;
+        if (!_havePrediction) { _predPrevX = t->x; _predPrevY = t->y; }
+    }
+    _havePrediction = true;
+}
+
+Screens::EntitySlot* Screens::findEntity(unsigned id) {
+    auto it = _slotById.find(id);
+    return it != _slotById.end() ? &_slots[it->second] : nullptr;
+}
+
+std::pair<Screens::EntitySlot*, bool> Screens::upsertEntity(const PackedEntity& e) {
+    auto [it, added] = _slotById.try_emplace(e.id, static_cast<std::uint32_t>(_slots.size()));
+    if (added) {
+        auto& list = _slotsByType[typeList(e.type)];
+        _slotKeys.push_back({e.id, 0});
+        _slots.push_back({e, EntityHistory{}, static_cast<std::uint32_t>(list.size())});
+        list.push_back(it->second);
+        return {&_slots.back(), true};
+    }
+    EntitySlot& slot = _slots[it->second];
+    if (typeList(slot.state.type) != typeList(e.type)) {
+        // Same id, other type: move it to the other list
+        auto& from = _slotsByType[typeList(slot.state.type)];
+        _slots[from.back()].typePos = slot.typePos;
+        from[slot.typePos] = from.back();
+        from.pop_back();
+        auto& to = _slotsByType[typeList(e.type)];
+        slot.typePos = static_cast<std::uint32_t>(to.size());
+        to.push_back(it->second);
+    }
+    slot.state = e;
+    return {&slot, false};
+}
+
+void Screens::removeSlot(std::uint32_t index) {
+    EntitySlot& slot = _slots[index];
+    auto& list = _slotsByType[typeList(slot.state.type)];
+    _slots[list.back()].typePos = slot.typePos;
+    list[slot.typePos] = list.back();
+    list.pop_back();
+    _slotById.erase(_slotKeys[index].id);
+    // The last slot takes its place: repoint its id and its type list entry
+    const auto last = static_cast<std::uint32_t>(_slots.size() - 1);
+    if (index != last) {
+        _slots[index] = std::move(_slots[last]);
+        _slotKeys[index] = _slotKeys[last];
+        _slotById[_slotKeys[index].id] = index;
+        _slotsByType[typeList(_slots[index].state.type)][_slots[index].typePos] = index;
+    }
+    _slots.pop_back();
+    _slotKeys.pop_back();
+}
+
+void Screens::removeEntity(unsigned id) {
+    auto it = _slotById.find(id);
+    if (it != _slotById.end()) removeSlot(it->second);
+}
+
+void Screens::clearEntities() {
+    _slotKeys.clear();
+    _slots.clear();
+    _slotById.clear();
+    for (auto& list : _slotsByType) list.clear();
+}
+
+void Screens::showEntities(std::uint32_t firstId, std::uint32_t lastId, double serverTime,
+                           const std::vector<rtype::net::PackedEntity>& range) {
+    const std::uint32_t stamp = ++_rangeStamp;
+    const std::size_t before = _slots.size();
+    std::size_t known = 0;
+    for (const auto& ne : range) {
+        PackedEntity e{};
+        e.id = ne.id;
+        e.type = static_cast<unsigned char>(ne.type);
+        e.x = rtype::net::dequantizePosition(ne.x);
+        e.y = rtype::net::dequantizePosition(ne.y);
+        rtype::net::unpackVelocity(ne.vel, e.vx, e.vy);
+        e.rgba = rtype::net::paletteColor(ne.color);
+        auto [slot, added] = upsertEntity(e);
+        if (!added) ++known;
+        slot->history.push({serverTime, e.x, e.y, e.vx, e.vy});
+        _slotKeys[slot - _slots.data()].seenIn = stamp;
+    }
+    // The range is authoritative: whatever we had in it and is not listed is
+    // gone. When it spans every id and lists everything we had, nothing is.
+    const bool everyId = firstId == 0 && lastId == std::numeric_limits<std::uint32_t>::max();
+    if (everyId && known == before) return;
+    for (std::size_t i = _slotKeys.size(); i-- > 0;) {
+        const SlotKey& k = _slotKeys[i];
+        if (k.seenIn != stamp && k.id >= firstId && k.id <= lastId) removeSlot(static_cast<std::uint32_t>(i));
+    }
+}
+
+void Screens::applyNetEvent(const client::net::NetEvent& ev) {
+    if (ev.kind == client::net::NetEvent::Kind::Packet) {
+        handleNetPacket(ev.packet.data(), ev.packet.size());
+        return;
+    }
+    const double serverTime = ev.serverTime / 1000.0;
+    trackServerClock(serverTime);
+    showEntities(ev.firstId, ev.lastId, serverTime, ev.entities);
+    if (_selfId >= ev.firstId && _selfId <= ev.lastId) {
+        if (const EntitySlot* self = findEntity(_selfId)) reconcileLocalShip(self->state.x, self->state.y, ev.inputAck);
+    }
+}
+
 void Screens::handleNetPacket(const char* data, std::size_t n) {
     if (!data || n < sizeof(rtype::net::Header)) return;
     const auto* h = reinterpret_cast<const rtype::net::Header*>(data);
     if (h->version != rtype::net::ProtocolVersion) return;
-    if (h->type == rtype::net::MsgType::State) {
-        const char* p = data + sizeof(rtype::net::Header);
-        if (n < sizeof(rtype::net::Header) + sizeof(rtype::net::StateHeader)) return;
-        auto* sh = reinterpret_cast<const rtype::net::StateHeader*>(p);
-        p += sizeof(rtype::net::StateHeader);
-        std::size_t count = sh->count;
-        if (n < sizeof(rtype::net::Header) + sizeof(rtype::net::StateHeader) + count * sizeof(rtype::net::PackedEntity)) return;
-        // Reconciliation: update or insert all received entities; mark as seen
-        auto* arr = reinterpret_cast<const rtype::net::PackedEntity*>(p);
-        std::unordered_set<unsigned> seenIds;
-        seenIds.reserve(count);
-        double nowSec = GetTime();
-        for (std::size_t i = 0; i < count; ++i) {
-            PackedEntity e{};
-            e.id = arr[i].id;
-            e.type = static_cast<unsigned char>(arr[i].type);
-            e.x = arr[i].x; e.y = arr[i].y; e.vx = arr[i].vx; e.vy = arr[i].vy;
-            e.rgba = arr[i].rgba;
-            _entityById[e.id] = e;
-            _missedById[e.id] = 0;
-            _lastSeenAt[e.id] = nowSec;
-            seenIds.insert(e.id);
-        }
-        // Increment miss counters for any id not seen in this snapshot
-        std::vector<unsigned> toErase;
-        toErase.reserve(_entityById.size());
-        for (const auto& kv : _entityById) {
-            unsigned id = kv.first;
-            if (seenIds.find(id) == seenIds.end()) {
-                int missed = (_missedById.count(id) ? _missedById[id] : 0) + 1;
-                _missedById[id] = missed;
-                double lastSeen = (_lastSeenAt.count(id) ? _lastSeenAt[id] : nowSec);
-                double elapsed = nowSec - lastSeen;
-                unsigned char type = kv.second.type;
-                double ttl = (type == 2 /* Enemy */) ? _expireSecondsEnemy : _expireSecondsDefault;
-                if (missed >= _missThreshold && elapsed >= ttl) toErase.push_back(id);
-            }
-        }
-        for (unsigned id : toErase) {
-            _entityById.erase(id);
-            _missedById.erase(id);
-            _lastSeenAt.erase(id);
-        }
-        // Rebuild render list with a stable ordering: players, bullets, powerups, enemies
-        _entities.clear();
-        _entities.reserve(_entityById.size());
-        auto appendByType = [&](unsigned char type) {
-            for (const auto& kv : _entityById) {
-                if (kv.second.type == type) _entities.push_back(kv.second);
-            }
-        };
-        appendByType(1); // Player
-        appendByType(3); // Bullet
-        appendByType(4); // Powerup (if used)
-        appendByType(2); // Enemy
-    } else if (h->type == rtype::net::MsgType::Despawn) {
+    if (h->type == rtype::net::MsgType::Despawn) {
         // Server explicitly told us to remove an entity - do it immediately
         const char* p = data + sizeof(rtype::net::Header);
         if (n < sizeof(rtype::net::Header) + sizeof(std::uint32_t)) return;
         std::uint32_t entityId;
         std::memcpy(&entityId, p, sizeof(entityId));
-        _entityById.erase(entityId);
-        _missedById.erase(entityId);
-        _lastSeenAt.erase(entityId);
-        // Rebuild render list immediately
-        _entities.clear();
-        _entities.reserve(_entityById.size());
-        auto appendByType = [&](unsigned char type) {
-            for (const auto& kv : _entityById) {
-                if (kv.second.type == type) _entities.push_back(kv.second);
-            }
-        };
-        appendByType(1); // Player
-        appendByType(3); // Bullet
-        appendByType(4); // Powerup
-        appendByType(2); // Enemy
+        removeEntity(entityId);
     } else if (h->type == rtype::net::MsgType::Roster) {
         const char* p = data + sizeof(rtype::net::Header);
         if (n < sizeof(rtype::net::Header) + sizeof(rtype::net::RosterHeader)) return;
@@ -128,6 +291,18 @@ void Screens::handleNetPacket(const char* data, std::size_t n) {
         _lobbyBaseLives = std::clamp<int>(ls->baseLives, 1, 6);
         _lobbyDifficulty = std::clamp<int>(ls->difficulty, 0, 2);
         _lobbyStarted = (ls->started != 0);
+    } else if (h->type == rtype::net::MsgType::Beam) {
+        const char* p = data + sizeof(rtype::net::Header);
+        if (n < sizeof(rtype::net::Header) + sizeof(rtype::net::BeamPayload)) return;
+        rtype::net::BeamPayload bp{};
+        std::memcpy(&bp, p, sizeof(bp));
+        // Hits were already applied by the server: just show the beam briefly
+        _beamActive = true;
+        _beamEndTime = GetTime() + 0.25; // beam visible for 250ms
+        _beamX = bp.x;
+        _beamY = bp.y;
+        _beamLength = bp.length;
+        _beamThickness = bp.thickness;
     } else if (h->type == rtype::net::MsgType::GameOver) {
         _gameOver = true;
     }
@@ -0,0 +1,150 @@
+#include "client/net/UdpLink.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace client::net {
+
+UdpLink::~UdpLink() {
+    close();
+}
+
+void UdpLink::open(const std::string& host, std::uint16_t port) {
+    close();
+    asio::error_code ec;
+    socket_.close(ec); // left open by a failed attempt
+    io_.restart();
+    asio::ip::udp::resolver resolver(io_);
+    server_ = *resolver.resolve(asio::ip::udp::v4(), host, std::to_string(port)).begin();
+    socket_.open(asio::ip::udp::v4());
+    doReceive();
+    // Runs until close() closes the socket: the pending receive keeps it busy
+    thread_ = std::thread([this] { io_.run(); });
+}
+
+void UdpLink::close() {
+    if (!thread_.joinable()) return;
+    asio::post(io_, [this] {
+        asio::error_code ec;
+        socket_.close(ec);
+    });
+    thread_.join();
+    NetEvent drop;
+    while (events_.pop(drop)) {}
+    for (auto& s : snapshots_) { s.id = 0; s.entities.clear(); }
+    for (auto& a : assemblies_) { a.id = 0; a.received = 0; }
+    lastSnapshotId_ = 0;
+    shownSnapshotId_ = 0;
+}
+
+void UdpLink::send(const void* data, std::size_t size) {
+    if (!thread_.joinable() || size > kMaxSend) return;
+    std::array<char, kMaxSend> buf;
+    std::memcpy(buf.data(), data, size);
+    asio::post(io_, [this, buf, size] {
+        asio::error_code ec;
+        socket_.send_to(asio::buffer(buf.data(), size), server_, 0, ec);
+    });
+}
+
+void UdpLink::doReceive() {
+    socket_.async_receive_from(asio::buffer(buffer_), from_, [this](const asio::error_code& ec, std::size_t n) {
+        if (ec == asio::error::operation_aborted || !socket_.is_open()) return;
+        if (!ec) handleDatagram(buffer_.data(), n);
+        doReceive();
+    });
+}
+
+void UdpLink::publish(NetEvent&& ev) {
+    if (!events_.push(std::move(ev))) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UdpLink::handleDatagram(const char* data, std::size_t size) {
+    if (size < sizeof(rtype::net::Header)) return;
+    rtype::net::Header h{};
+    std::memcpy(&h, data, sizeof(h));
+    if (h.version != rtype::net::ProtocolVersion) return;
+    if (h.type == rtype::net::MsgType::StateDelta) {
+        handleStateFragment(data + sizeof(h), size - sizeof(h));
+        return;
+    }
+    NetEvent ev;
+    ev.kind = NetEvent::Kind::Packet;
+    ev.packet.assign(data, data + size);
+    publish(std::move(ev));
+}
+
+void UdpLink::handleStateFragment(const char* p, std::size_t n) {
+    if (n < sizeof(rtype::net::StateDeltaHeader)) return;
+    rtype::net::StateDeltaHeader sh{};
+    std::memcpy(&sh, p, sizeof(sh));
+    p += sizeof(sh);
+    n -= sizeof(sh);
+    if (sh.fragmentCount == 0 || sh.fragmentCount > rtype::net::MaxSnapshotFragments || sh.fragment >= sh.fragmentCount) return;
+    if (sh.firstId > sh.lastId) return;
+    // Late or duplicate datagram: a newer complete snapshot is already shown
+    if (sh.snapshotId <= lastSnapshotId_) return;
+    static const std::vector<rtype::net::PackedEntity> kEmpty;
+    const std::vector<rtype::net::PackedEntity>* base = &kEmpty;
+    if (sh.baselineId != 0) {
+        const auto& slot = snapshots_[sh.baselineId % snapshots_.size()];
+        if (slot.id != sh.baselineId) return; // never decoded it; the server falls back once acks stop matching
+        base = &slot.entities;
+    }
+
+    // Every fragment is usable on its own: publish its id range right away
+    NetEvent ev;
+    ev.kind = NetEvent::Kind::Entities;
+    if (!rtype::net::mergeDeltaRecords(*base, sh.firstId, sh.lastId, p, n, sh.count, ev.entities)) return;
+    if (sh.snapshotId >= shownSnapshotId_) {
+        ev.snapshotId = sh.snapshotId;
+        ev.serverTime = sh.serverTime;
+        ev.inputAck = sh.inputAck;
+        ev.firstId = sh.firstId;
+        ev.lastId = sh.lastId;
+        publish(std::move(ev));
+        shownSnapshotId_ = sh.snapshotId;
+    }
+
+    // Only complete snapshots become baselines
+    auto& as = assemblies_[sh.snapshotId % assemblies_.size()];
+    if (as.id != sh.snapshotId) {
+        as.id = sh.snapshotId;
+        as.count = sh.fragmentCount;
+        as.received = 0;
+    }
+    if (as.count != sh.fragmentCount) return;
+    as.headers[sh.fragment] = sh;
+    as.records[sh.fragment].assign(p, p + n);
+    as.received |= 1u << sh.fragment;
+    if (as.received != (1u << sh.fragmentCount) - 1) return;
+
+    std::vector<rtype::net::PackedEntity> full;
+    full.reserve(base->size());
+    for (std::uint8_t k = 0; k < sh.fragmentCount; ++k) {
+        const auto& fh = as.headers[k];
+        const auto& rec = as.records[k];
+        if (!rtype::net::mergeDeltaRecords(*base, fh.firstId, fh.lastId, rec.data(), rec.size(), fh.count, full)) return;
+    }
+    auto& slot = snapshots_[sh.snapshotId % snapshots_.size()];
+    slot.id = sh.snapshotId;
+    slot.entities = std::move(full);
+    lastSnapshotId_ = sh.snapshotId;
+    as.id = 0;
+    sendStateAck(sh.snapshotId);
+}
+
+void UdpLink::sendStateAck(std::uint32_t snapshotId) {
+    rtype::net::Header hdr{};
+    hdr.version = rtype::net::ProtocolVersion;
+    hdr.type = rtype::net::MsgType::StateAck;
+    rtype::net::StateAckPayload p{ snapshotId };
+    hdr.size = sizeof(p);
+    std::array<char, sizeof(hdr) + sizeof(p)> buf{};
+    std::memcpy(buf.data(), &hdr, sizeof(hdr));
+    std::memcpy(buf.data() + sizeof(hdr), &p, sizeof(p));
+    // Already on the network thread: straight to the socket
+    asio::error_code ec;
+    socket_.send_to(asio::buffer(buf), server_, 0, ec);
+}
+
+}
@@ -17,6 +17,8 @@ void Screens::drawGameplay(ScreenState& screen) {
     // Keep the latest snapshot fresh
     pumpNetworkOnce();
     if (_serverReturnToMenu) { leaveSession(); screen = ScreenState::NotEnoughPlayers; return; }
+    // Place every entity at the same instant, slightly behind the newest snapshot
+    if (_haveServerClock) interpolateEntities(GetTime() - _serverClockOffset - interpolationDelay());
 
     // Compute playable band similar to singleplayer (reserve bottom bar height)
     int w = GetScreenWidth();
@@ -30,7 +32,7 @@ void Screens::drawGameplay(ScreenState& screen) {
 
     // Find self entity for input edge-gating
     const PackedEntity* self = nullptr;
-    for (const auto& ent : _entities) { if (ent.type == 1 && ent.id == _selfId) { self = &ent; break; } }
+    if (const EntitySlot* slot = findEntity(_selfId); slot && slot->state.type == 1) self = &slot->state;
 
     // Build input from arrows OR WASD, gate within playable area based on self pos
     bool isAlive = (_playerLives > 0) && !_gameOver;
@@ -67,9 +69,12 @@ void Screens::drawGameplay(ScreenState& screen) {
     // Only send shoot input if not overheated (to mimic singleplayer feel)
     if (isAlive && wantShoot && _spHeat > 0.f) bits |= rtype::net::InputShoot;
 
-    // Send inputs at ~30Hz
+    // Sample every input tick, send the pending samples at ~30Hz
+    sampleInput(bits, GetFrameTime());
+    // Except ours: drawn where the inputs sampled so far put it
+    placeLocalShip();
     double now = GetTime();
-    if (now - _lastSend > 1.0/30.0) { sendInput(bits); _lastSend = now; }
+    if (now - _lastSend > 1.0/30.0) { sendInput(); _lastSend = now; }
 
     // --- Bottom HUD: Lives (left) + Overheat bar (center) ---
     int bottomY = h - bottomBarH;
@@ -101,23 +106,14 @@ void Screens::drawGameplay(ScreenState& screen) {
     DrawText(scoreText.c_str(), scoreMargin, scoreMargin, hudFontScore, RAYWHITE);
 
     // --- World rendering (rectangles like singleplayer) ---
-    if (_entities.empty()) {
+    if (_slots.empty()) {
         titleCentered("Connecting to game...", (int)(GetScreenHeight()*0.5f), 24, RAYWHITE);
     }
-    double nowSec = GetTime();
-    for (auto& e : _entities) {
-        // Extrapolate position if entity stopped updating (prevent freezing)
-        if (_lastSeenAt.count(e.id)) {
-            double elapsed = nowSec - _lastSeenAt[e.id];
-            if (elapsed > 0.05 && elapsed < 2.0) { // Only extrapolate for 50ms-2s gap
-                e.x += e.vx * elapsed;
-                e.y += e.vy * elapsed;
-            }
-        }
+    forEachEntity([&](const PackedEntity& e) {
         if (e.type == 1) {
             // Player ship
             if (e.id == _selfId && _playerLives <= 0) {
-                continue; // hide local ship if dead
+                return; // hide local ship if dead
             }
             float x = e.x, y = e.y;
             if (y < playableMinY) y = (float)playableMinY;
@@ -150,6 +146,27 @@ void Screens::drawGameplay(ScreenState& screen) {
             DrawCircle(cx, cy, radius, fill);
             DrawCircleLines(cx, cy, radius, line);
         }
+    });
+
+    // Charged beam from a server Beam event
+    if (_beamActive) {
+        if (GetTime() > _beamEndTime) {
+            _beamActive = false;
+        } else {
+            float bx = _beamX;
+            float by = _beamY;
+            float bw = _beamLength > 0.f ? _beamLength : (float)w - bx;
+            float halfT = _beamThickness * 0.5f;
+            float y0 = std::max((float)playableMinY, by - halfT);
+            float y1 = std::min((float)playableMaxY, by + halfT);
+            if (y1 > y0) {
+                // Core
+                DrawRectangle((int)bx, (int)y0, (int)bw, (int)(y1 - y0), (Color){120, 200, 255, 220});
+                // Glow borders
+                DrawRectangle((int)bx, (int)(y0 - 4), (int)bw, 4, (Color){120, 200, 255, 120});
+                DrawRectangle((int)bx, (int)y1, (int)bw, 4, (Color){120, 200, 255, 120});
+            }
+        }
     }
 
     // If everyone is dead, go to dedicated Game Over screen
@@ -158,7 +175,7 @@ void Screens::drawGameplay(ScreenState& screen) {
     if (everyoneDead) {
         leaveSession();
         _connected = false;
-        _entities.clear();
+        clearEntities();
         _gameOver = true;
         screen = ScreenState::GameOver;
         return;
@@ -168,7 +185,7 @@ void Screens::drawGameplay(ScreenState& screen) {
     if (_gameOver) {
         DrawRectangle(0, 0, w, h, (Color){0, 0, 0, 180});
         titleCentered("Game Over", (int)(h * 0.40f), (int)(h * 0.10f), RAYWHITE);
-        if (IsKeyPressed(KEY_ESCAPE)) { teardownNet(); _connected = false; _entities.clear(); _gameOver = false; screen = ScreenState::Menu; return; }
+        if (IsKeyPressed(KEY_ESCAPE)) { teardownNet(); _connected = false; clearEntities(); _gameOver = false; screen = ScreenState::Menu; return; }
     }
 }
 
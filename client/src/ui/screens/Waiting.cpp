@@ -122,7 +122,7 @@ void Screens::drawWaiting(ScreenState& screen) {
     if (button(cancelBtn, "Cancel", baseFont, BLACK, LIGHTGRAY, GRAY)) {
         teardownNet();
         _connected = false;
-        _entities.clear();
+        clearEntities();
         screen = ScreenState::Menu;
         return;
     }
@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
 #include <array>
+#include <vector>
 
 namespace rtype::net {
 
@@ -8,7 +10,7 @@ enum class MsgType : std::uint8_t {
     Hello = 1,
     HelloAck,
     Input,
-    State,
+    State,      // retired full snapshot, replaced by StateDelta; never sent, keeps the numbering
     Spawn,
     Despawn,
     Ping,
@@ -24,6 +26,9 @@ enum class MsgType : std::uint8_t {
     // New messages
     Disconnect,     // client -> server: explicit disconnect notice
     ReturnToMenu,   // server -> client: ask client to return to menu (e.g., too few players)
+    Beam,           // server -> clients: one-shot charged beam (already resolved server-side)
+    StateDelta,     // server -> client: world snapshot encoded against an acknowledged one
+    StateAck,       // client -> server: newest snapshot decoded, usable as a baseline
 
     TcpWelcome = 100,
     StartGame  = 101
@@ -35,7 +40,7 @@ struct Header {
     std::uint8_t version;
 };
 
-static constexpr std::uint8_t ProtocolVersion = 1;
+static constexpr std::uint8_t ProtocolVersion = 7;
 static constexpr std::size_t HeaderSize = sizeof(Header);
 
 // --- Minimal binary protocol for inputs and world state ---
@@ -58,28 +63,112 @@ enum class EntityType : std::uint8_t {
     Powerup = 4,
 };
 
+// Clients sample their input once per simulation tick (the server runs at
+// InputTickRate too) and every Input datagram repeats the newest samples, so
+// a lost datagram costs nothing as long as one of the next few arrives.
+static constexpr double InputTickRate = 60.0;
+static constexpr std::size_t MaxRedundantInputs = 8;
+
 #pragma pack(push, 1)
+// Sent with only its first `count` bits entries: 5 + count bytes
 struct InputPacket {
-    std::uint32_t sequence; // client-side increasing sequence id
-    std::uint8_t bits;      // combination of Input* bits
+    std::uint32_t sequence; // newest sample's sequence: one per input tick, from 1; echoed in StateDeltaHeader::inputAck
+    std::uint8_t count;     // samples carried, 1..MaxRedundantInputs
+    std::uint8_t bits[MaxRedundantInputs]; // Input* bits, oldest first: bits[k] is sample `sequence - count + 1 + k`
 };
 
+// Quantized entity state. The world is 960x600, so positions are 16-bit fixed
+// point and velocities 12-bit; the colour is an index into EntityPalette.
+// Build and read it with packEntity() and the helpers below.
 struct PackedEntity {
     std::uint32_t id;
     EntityType type;
-    float x;
-    float y;
-    float vx;
-    float vy;
-    std::uint32_t rgba; // 0xRRGGBBAA
+    std::uint16_t x;     // quantizePosition()
+    std::uint16_t y;
+    std::uint8_t vel[3]; // vx then vy, signed 12-bit each, packVelocity()
+    std::uint8_t color;  // EntityPalette index
+};
+
+// A snapshot is sent as 1..MaxSnapshotFragments StateDelta datagrams sharing
+// its snapshotId. Each one carries the records of a contiguous id range, so it
+// can be applied on its own; together the ranges cover every id.
+// The StateDelta payload is: StateDeltaHeader + count delta records. A record
+// is the entity id, a DeltaField mask, then each field whose bit is set, in bit
+// order, with the PackedEntity encoding. Entities without a record are
+// unchanged from the baseline; records come in increasing id order.
+struct StateDeltaHeader {
+    std::uint32_t snapshotId;    // increasing, never 0
+    std::uint32_t serverTime;    // ms since the session started, when the snapshot was taken
+    std::uint32_t baselineId;    // snapshot the records apply to, 0 = empty world
+    std::uint32_t inputAck;      // newest Input sequence from this client applied before the snapshot
+    std::uint8_t fragment;       // index of this datagram in the snapshot
+    std::uint8_t fragmentCount;  // datagrams making up the snapshot
+    std::uint32_t firstId;       // ids covered by this fragment: [firstId, lastId]
+    std::uint32_t lastId;
+    std::uint16_t count;         // number of records following
 };
 
-// The State payload is: StateHeader + N * PackedEntity
-struct StateHeader {
-    std::uint16_t count; // number of entities following
+struct StateAckPayload {
+    std::uint32_t snapshotId;
 };
 #pragma pack(pop)
 
+enum : std::uint8_t {
+    DeltaType    = 1 << 0,
+    DeltaX       = 1 << 1,
+    DeltaY       = 1 << 2,
+    DeltaVel     = 1 << 3,
+    DeltaColor   = 1 << 4,
+    DeltaRemoved = 1 << 7, // entity left the world; no field follows
+    DeltaAll     = DeltaType | DeltaX | DeltaY | DeltaVel | DeltaColor,
+};
+
+// Positions: 1/16 px steps over [-512, 3584) so off-screen spawns still fit
+static constexpr float PositionOrigin = -512.f;
+static constexpr float PositionScale = 16.f;
+// Velocities: 1 px/s steps, clamped to [-2048, 2047]
+static constexpr int VelocityLimit = 2047;
+
+// Every colour the server assigns; anything else maps to the nearest entry
+inline constexpr std::array<std::uint32_t, 14> EntityPalette{
+    0xFFFFFFFFu, // default
+    0x55AAFFFFu, // player
+    0xFFFF55FFu, // player bullet
+    0xFFAA00FFu, // enemy bullet
+    0xFF5555FFu, 0xE06666FFu, 0xCC4444FFu, 0xDD7777FFu, 0xAA3333FFu, // enemies
+    0x9646B4FFu, // boss
+    0x64DC78FFu, 0x50AAFFFFu, 0xAA50C8FFu, 0xF0DC50FFu, // powerups
+};
+
+std::uint16_t quantizePosition(float v);
+float dequantizePosition(std::uint16_t q);
+void packVelocity(float vx, float vy, std::uint8_t out[3]);
+void unpackVelocity(const std::uint8_t in[3], float& vx, float& vy);
+std::uint8_t paletteIndex(std::uint32_t rgba);
+std::uint32_t paletteColor(std::uint8_t index);
+PackedEntity packEntity(std::uint32_t id, EntityType type, float x, float y, float vx, float vy, std::uint32_t rgba);
+
+static constexpr std::size_t MaxSnapshotFragments = 8;
+
+// Largest record: id + mask + every field
+static constexpr std::size_t MaxDeltaRecordSize = sizeof(std::uint32_t) + 1 + (sizeof(PackedEntity) - sizeof(std::uint32_t));
+
+// Fields of `cur` that differ from `base` (same entity)
+std::uint8_t diffEntity(const PackedEntity& base, const PackedEntity& cur);
+std::size_t deltaRecordSize(std::uint8_t fields);
+// Writes the record for `cur` restricted to `fields` (MaxDeltaRecordSize bytes
+// available), returns its size
+std::size_t writeDeltaRecord(char* out, const PackedEntity& cur, std::uint8_t fields);
+// Reads one record: fields present are applied onto `ent`, which the caller
+// fills from the baseline first. Returns the bytes read, 0 if truncated.
+std::size_t readDeltaRecord(const char* in, std::size_t size, std::uint32_t& id, std::uint8_t& fields, PackedEntity& ent);
+// Decodes the `count` records of one StateDelta fragment covering ids
+// [first, last]: the baseline entities of that range (sorted by id) merged with
+// the records, appended to `out` in id order. False if a record is truncated or
+// out of range.
+bool mergeDeltaRecords(const std::vector<PackedEntity>& base, std::uint32_t first, std::uint32_t last, const char* in,
+                       std::size_t size, std::size_t count, std::vector<PackedEntity>& out);
+
 // --- Lightweight roster message (player list) ---
 // Payload layout: RosterHeader + count * PlayerEntry
 #pragma pack(push, 1)
@@ -138,6 +227,17 @@ struct GameOverPayload {
 };
 #pragma pack(pop)
 
+// Charged beam fired this tick; hits were applied on the server, this is for rendering only
+#pragma pack(push, 1)
+struct BeamPayload {
+    std::uint32_t ownerId;  // player who fired
+    float x;                // origin (left end)
+    float y;                // vertical center
+    float length;           // extends to the right
+    float thickness;
+};
+#pragma pack(pop)
+
 // Client says Hello with username, Server replies with HelloAck with UDP port and an auth token.
 #pragma pack(push, 1)
 struct HelloAckPayload {
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace rtype::common {
+
+// Bounded lock-free ring for exactly one producer thread and one consumer
+// thread. Neither side blocks: push() fails when the ring is full and pop()
+// fails when it is empty. Each side caches the other's index so the shared
+// atomics are only re-read when the cached value says full/empty.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : slots_(std::make_unique<T[]>(Capacity)) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side. On failure `item` is left untouched.
+    bool push(T&& item) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tailCache_ == Capacity) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head - tailCache_ == Capacity) return false;
+        }
+        slots_[head & (Capacity - 1)] = std::move(item);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& out) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == headCache_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail == headCache_) return false;
+        }
+        out = std::move(slots_[tail & (Capacity - 1)]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Producer and consumer indices on separate cache lines, each next to the
+    // cache only its own thread touches
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tailCache_ = 0;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t headCache_ = 0;
+    std::unique_ptr<T[]> slots_;
+};
+
+}
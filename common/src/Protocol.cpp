@@ -1,3 +1,168 @@
 #include "common/Protocol.hpp"
-using namespace rtype::net;
-// Intentionally empty for now; placeholder for helpers
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// By value: PackedEntity members are unaligned
+template <typename T>
+void put(char*& out, T v) {
+    std::memcpy(out, &v, sizeof(v));
+    out += sizeof(v);
+}
+
+template <typename T>
+T get(const char*& in) {
+    T v;
+    std::memcpy(&v, in, sizeof(v));
+    in += sizeof(v);
+    return v;
+}
+
+int quantizeVelocity(float v) {
+    if (!(v == v)) return 0; // NaN
+    return std::clamp(static_cast<int>(std::lround(std::clamp(v, -4096.f, 4096.f))), -rtype::net::VelocityLimit - 1,
+                      rtype::net::VelocityLimit);
+}
+
+float signExtend12(unsigned v) {
+    return static_cast<float>(static_cast<int>(v << 20) >> 20);
+}
+
+}
+
+namespace rtype::net {
+
+std::uint16_t quantizePosition(float v) {
+    float q = (v - PositionOrigin) * PositionScale;
+    if (!(q > 0.f)) return 0; // also NaN
+    if (q >= 65535.f) return 65535;
+    return static_cast<std::uint16_t>(std::lround(q));
+}
+
+float dequantizePosition(std::uint16_t q) {
+    return static_cast<float>(q) / PositionScale + PositionOrigin;
+}
+
+void packVelocity(float vx, float vy, std::uint8_t out[3]) {
+    unsigned x = static_cast<unsigned>(quantizeVelocity(vx)) & 0xFFFu;
+    unsigned y = static_cast<unsigned>(quantizeVelocity(vy)) & 0xFFFu;
+    out[0] = static_cast<std::uint8_t>(x);
+    out[1] = static_cast<std::uint8_t>((x >> 8) | (y << 4));
+    out[2] = static_cast<std::uint8_t>(y >> 4);
+}
+
+void unpackVelocity(const std::uint8_t in[3], float& vx, float& vy) {
+    vx = signExtend12(in[0] | ((in[1] & 0x0Fu) << 8));
+    vy = signExtend12((in[1] >> 4) | (static_cast<unsigned>(in[2]) << 4));
+}
+
+std::uint8_t paletteIndex(std::uint32_t rgba) {
+    std::uint8_t best = 0;
+    long bestDist = -1;
+    for (std::size_t i = 0; i < EntityPalette.size(); ++i) {
+        long d = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            long c = static_cast<long>((rgba >> shift) & 0xFFu) - static_cast<long>((EntityPalette[i] >> shift) & 0xFFu);
+            d += c * c;
+        }
+        if (d == 0) return static_cast<std::uint8_t>(i);
+        if (bestDist < 0 || d < bestDist) { bestDist = d; best = static_cast<std::uint8_t>(i); }
+    }
+    return best;
+}
+
+std::uint32_t paletteColor(std::uint8_t index) {
+    return index < EntityPalette.size() ? EntityPalette[index] : EntityPalette[0];
+}
+
+PackedEntity packEntity(std::uint32_t id, EntityType type, float x, float y, float vx, float vy, std::uint32_t rgba) {
+    PackedEntity pe{};
+    pe.id = id;
+    pe.type = type;
+    pe.x = quantizePosition(x);
+    pe.y = quantizePosition(y);
+    packVelocity(vx, vy, pe.vel);
+    pe.color = paletteIndex(rgba);
+    return pe;
+}
+
+std::uint8_t diffEntity(const PackedEntity& base, const PackedEntity& cur) {
+    // Quantized values: sub-step jitter never shows up as a change
+    std::uint8_t fields = 0;
+    if (base.type != cur.type) fields |= DeltaType;
+    if (base.x != cur.x) fields |= DeltaX;
+    if (base.y != cur.y) fields |= DeltaY;
+    if (std::memcmp(base.vel, cur.vel, sizeof(base.vel)) != 0) fields |= DeltaVel;
+    if (base.color != cur.color) fields |= DeltaColor;
+    return fields;
+}
+
+std::size_t deltaRecordSize(std::uint8_t fields) {
+    std::size_t n = sizeof(std::uint32_t) + 1;
+    if (fields & DeltaType) n += sizeof(EntityType);
+    if (fields & DeltaX) n += sizeof(std::uint16_t);
+    if (fields & DeltaY) n += sizeof(std::uint16_t);
+    if (fields & DeltaVel) n += sizeof(PackedEntity::vel);
+    if (fields & DeltaColor) n += sizeof(std::uint8_t);
+    return n;
+}
+
+std::size_t writeDeltaRecord(char* out, const PackedEntity& cur, std::uint8_t fields) {
+    char* p = out;
+    put(p, cur.id);
+    put(p, fields);
+    if (fields & DeltaType) put(p, cur.type);
+    if (fields & DeltaX) put(p, cur.x);
+    if (fields & DeltaY) put(p, cur.y);
+    if (fields & DeltaVel) {
+        std::memcpy(p, cur.vel, sizeof(cur.vel));
+        p += sizeof(cur.vel);
+    }
+    if (fields & DeltaColor) put(p, cur.color);
+    return static_cast<std::size_t>(p - out);
+}
+
+std::size_t readDeltaRecord(const char* in, std::size_t size, std::uint32_t& id, std::uint8_t& fields, PackedEntity& ent) {
+    if (size < sizeof(std::uint32_t) + 1) return 0;
+    const char* p = in;
+    id = get<std::uint32_t>(p);
+    fields = get<std::uint8_t>(p);
+    if (size < deltaRecordSize(fields)) return 0;
+    ent.id = id;
+    if (fields & DeltaType) ent.type = get<EntityType>(p);
+    if (fields & DeltaX) ent.x = get<std::uint16_t>(p);
+    if (fields & DeltaY) ent.y = get<std::uint16_t>(p);
+    if (fields & DeltaVel) {
+        std::memcpy(ent.vel, p, sizeof(ent.vel));
+        p += sizeof(ent.vel);
+    }
+    if (fields & DeltaColor) ent.color = get<std::uint8_t>(p);
+    return static_cast<std::size_t>(p - in);
+}
+
+bool mergeDeltaRecords(const std::vector<PackedEntity>& base, std::uint32_t first, std::uint32_t last, const char* in,
+                       std::size_t size, std::size_t count, std::vector<PackedEntity>& out) {
+    auto it = std::lower_bound(base.begin(), base.end(), first, [](const PackedEntity& e, std::uint32_t id) { return e.id < id; });
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint32_t id = 0;
+        std::uint8_t fields = 0;
+        PackedEntity ent{};
+        // Peek the id to copy the baseline entries before it
+        if (size < sizeof(id)) return false;
+        std::memcpy(&id, in, sizeof(id));
+        if (id < first || id > last) return false;
+        for (; it != base.end() && it->id < id; ++it) out.push_back(*it);
+        if (it != base.end() && it->id == id) ent = *it++;
+        std::size_t used = readDeltaRecord(in, size, id, fields, ent);
+        if (used == 0) return false;
+        in += used;
+        size -= used;
+        if (!(fields & DeltaRemoved)) out.push_back(ent);
+    }
+    for (; it != base.end() && it->id <= last; ++it) out.push_back(*it);
+    return true;
+}
+
+}
@@ -0,0 +1,70 @@
+// Counts the box tests of the collision systems over a scripted match, with the
+// grid broadphase next to what a brute force scan of the same queries would do.
+// Usage: rtype_grid_bench [ticks] [players]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "rt/ecs/Registry.hpp"
+#include "rt/game/Systems.hpp"
+
+using namespace rt::game;
+
+int main(int argc, char** argv) {
+    const int ticks = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const int players = argc > 2 ? std::atoi(argv[2]) : 4;
+    const float dt = 1.f / 60.f;
+
+    rt::ecs::Registry r;
+    SpatialGrid grid;
+    std::vector<BeamEvent> beams;
+    std::mt19937 rng(7);
+    float elapsed = 0.f;
+    std::int32_t teamScore = 0;
+    addMatchSystems(r, grid, beams, rng, &elapsed, &teamScore);
+    for (int p = 0; p < players; ++p) {
+        auto e = r.create();
+        r.emplace<Transform>(e, {50.f, 80.f + static_cast<float>(p % 8) * 60.f});
+        r.emplace<Velocity>(e, {});
+        r.emplace<NetType>(e, {rtype::net::EntityType::Player});
+        r.emplace<ColorRGBA>(e, {});
+        r.emplace<PlayerInput>(e, {0, 150.f});
+        r.emplace<Shooter>(e, {});
+        r.emplace<ChargeGun>(e, {});
+        r.emplace<Size>(e, {20.f, 12.f});
+        r.emplace<Score>(e, {});
+        r.emplace<HitFlag>(e, {});
+        // Keep everyone alive and shooting for the whole run
+        r.emplace<Invincible>(e, {1e9f});
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::size_t peakBullets = 0;
+    std::size_t peakEnemies = 0;
+    auto t0 = Clock::now();
+    for (int t = 0; t < ticks; ++t) {
+        elapsed += dt;
+        // Hold fire, sweeping up and down; charge a beam for a second every five
+        std::uint8_t bits = (t % 300 < 60) ? rtype::net::InputCharge : rtype::net::InputShoot;
+        bits |= (t / 120) % 2 ? rtype::net::InputUp : rtype::net::InputDown;
+        for (auto [e, in] : r.storage<PlayerInput>()) in.bits = bits;
+        r.update(dt);
+        beams.clear();
+        teamScore = 0;
+        for (auto [e, sc] : r.storage<Score>()) teamScore += sc.value;
+        peakBullets = std::max(peakBullets, r.storage<BulletTag>().size());
+        peakEnemies = std::max(peakEnemies, grid.size(SpatialGrid::Enemies));
+    }
+    auto t1 = Clock::now();
+
+    const double tickMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / ticks;
+    std::printf("grid: %d ticks, %d players, peak %zu bullets / %zu enemies, %.4f ms/tick\n", ticks, players,
+                peakBullets, peakEnemies, tickMs);
+    std::printf("box tests: %zu with the grid, %zu brute force (%.1fx fewer)\n", grid.pairTests(),
+                grid.bruteForcePairTests(),
+                grid.pairTests() ? static_cast<double>(grid.bruteForcePairTests()) / grid.pairTests() : 0.0);
+    return 0;
+}
@@ -0,0 +1,40 @@
+// Times MovementSystem over a world of moving and static entities.
+// Usage: rtype_movement_bench [moving entities] [ticks]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "rt/ecs/Registry.hpp"
+#include "rt/game/Systems.hpp"
+#include "rt/math/Integrate.hpp"
+
+using namespace rt::game;
+
+int main(int argc, char** argv) {
+    const int moving = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int ticks = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const float dt = 1.f / 60.f;
+
+    rt::ecs::Registry r;
+    // One static entity (Transform only) every four moving ones, interleaved,
+    // so align() has holes to close on the first tick
+    for (int i = 0; i < moving; ++i) {
+        auto e = r.create();
+        r.emplace<Transform>(e, {static_cast<float>(i % 1000), static_cast<float>(i / 1000)});
+        r.emplace<Velocity>(e, {-60.f, static_cast<float>(i % 7) - 3.f});
+        if (i % 4 == 0) r.emplace<Transform>(r.create(), {0.f, 0.f});
+    }
+    MovementSystem movement;
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    movement.update(r, dt);
+    auto t1 = Clock::now();
+    for (int t = 0; t < ticks; ++t) movement.update(r, dt);
+    auto t2 = Clock::now();
+
+    const double firstMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    const double tickMs = std::chrono::duration<double, std::milli>(t2 - t1).count() / ticks;
+    std::printf("movement (%s): %d moving entities, first tick %.3f ms, then %.4f ms/tick over %d ticks\n",
+                rt::math::integrateBackend(), moving, firstMs, tickMs, ticks);
+    return 0;
+}
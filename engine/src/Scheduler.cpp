@@ -0,0 +1,155 @@
+#include "rt/ecs/Scheduler.hpp"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include "rt/ecs/Registry.hpp"
+
+namespace rt::ecs {
+
+namespace {
+
+struct Declared {
+    bool declared = false;
+    bool structural = false;
+    Signature reads = 0;
+    Signature writes = 0;
+    std::vector<const void*> resources;
+};
+
+bool conflicts(const Declared& a, const Declared& b) {
+    if (!a.declared || !b.declared) return true;
+    if ((a.writes & (b.reads | b.writes)) != 0 || (b.writes & a.reads) != 0) return true;
+    for (const void* p : a.resources)
+        if (std::find(b.resources.begin(), b.resources.end(), p) != b.resources.end()) return true;
+    return false;
+}
+
+}
+
+Scheduler::Scheduler(unsigned workers) : maxWorkers_(workers) {}
+
+Scheduler::~Scheduler() { stopWorkers(); }
+
+void Scheduler::startWorkers(unsigned count) {
+    stop_ = false;
+    generation_ = 0;
+    threads_.reserve(count);
+    for (unsigned i = 0; i < count; ++i) threads_.emplace_back([this] { workerLoop(); });
+}
+
+void Scheduler::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+}
+
+void Scheduler::build(Registry& r, const std::vector<std::unique_ptr<System>>& systems) {
+    std::vector<Declared> decls(systems.size());
+    for (std::size_t i = 0; i < systems.size(); ++i) {
+        Access access;
+        Declared& d = decls[i];
+        d.declared = systems[i]->declareAccess(access);
+        if (!d.declared) continue;
+        // Resolving also creates the pools, so workers never insert into the pool table
+        for (auto id : access.reads_) d.reads |= Signature{1} << id(r);
+        for (auto id : access.writes_) d.writes |= Signature{1} << id(r);
+        d.resources = std::move(access.resources_);
+        d.structural = access.structural_;
+    }
+
+    stages_.clear();
+    structural_.assign(systems.size(), false);
+    std::vector<std::size_t> stageOf(systems.size(), 0);
+    for (std::size_t i = 0; i < systems.size(); ++i) {
+        structural_[i] = decls[i].structural || !decls[i].declared;
+        std::size_t s = 0;
+        for (std::size_t j = 0; j < i; ++j)
+            if (decls[j].structural || conflicts(decls[i], decls[j])) s = std::max(s, stageOf[j] + 1);
+        stageOf[i] = s;
+        if (stages_.size() <= s) stages_.resize(s + 1);
+        stages_[s].push_back(i);
+    }
+    buffers_.resize(systems.size());
+
+    // The calling thread takes a share of every stage
+    std::size_t widest = 0;
+    for (const auto& stage : stages_) widest = std::max(widest, stage.size());
+    unsigned wanted = static_cast<unsigned>(std::min<std::size_t>(maxWorkers_, widest > 0 ? widest - 1 : 0));
+    if (wanted != threads_.size()) {
+        stopWorkers();
+        startWorkers(wanted);
+    }
+}
+
+void Scheduler::run(Registry& r, const std::vector<std::unique_ptr<System>>& systems, float dt) {
+    reg_ = &r;
+    systems_ = &systems;
+    dt_ = dt;
+    for (const auto& stage : stages_) {
+        if (stage.size() == 1 || threads_.empty()) {
+            for (std::size_t i : stage) runOne(i);
+        } else {
+            {
+                std::lock_guard<std::mutex> lock(m_);
+                stage_ = &stage;
+                next_.store(0, std::memory_order_relaxed);
+                pending_ = threads_.size();
+                ++generation_;
+            }
+            wake_.notify_all();
+            drain();
+            std::unique_lock<std::mutex> lock(m_);
+            done_.wait(lock, [this] { return pending_ == 0; });
+        }
+        if (error_) {
+            for (auto& b : buffers_) b.clear();
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+        // Sync point: structural changes of this stage become visible to the next one.
+        // Only a structural system, always the last of its stage, may have recorded any.
+        for (std::size_t i : stage) {
+            assert((structural_[i] || buffers_[i].empty()) && "system recorded commands without declaring structural()");
+            buffers_[i].flush(r);
+        }
+    }
+}
+
+void Scheduler::workerLoop() {
+    std::size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+        drain();
+        std::lock_guard<std::mutex> lock(m_);
+        if (--pending_ == 0) done_.notify_one();
+    }
+}
+
+void Scheduler::drain() {
+    for (;;) {
+        std::size_t k = next_.fetch_add(1, std::memory_order_relaxed);
+        if (k >= stage_->size()) return;
+        runOne((*stage_)[k]);
+    }
+}
+
+void Scheduler::runOne(std::size_t system) {
+    Registry::threadCommands_ = &buffers_[system];
+    try {
+        (*systems_)[system]->update(*reg_, dt_);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_);
+        if (!error_) error_ = std::current_exception();
+    }
+    Registry::threadCommands_ = nullptr;
+}
+
+}
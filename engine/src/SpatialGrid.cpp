@@ -0,0 +1,79 @@
+#include "rt/game/SpatialGrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace rt::game;
+
+SpatialGrid::SpatialGrid(float worldW, float worldH, float cellSize)
+    : cell_(cellSize),
+      cols_(std::max(1, static_cast<int>(std::ceil(worldW / cellSize)))),
+      rows_(std::max(1, static_cast<int>(std::ceil(worldH / cellSize)))) {}
+
+int SpatialGrid::cellX(float x) const {
+    return std::clamp(static_cast<int>(std::floor(x / cell_)), 0, cols_ - 1);
+}
+
+int SpatialGrid::cellY(float y) const {
+    return std::clamp(static_cast<int>(std::floor(y / cell_)), 0, rows_ - 1);
+}
+
+void SpatialGrid::clear() {
+    for (auto& l : layers_) l.boxes.clear();
+}
+
+void SpatialGrid::insert(Layer layer, rt::ecs::Entity e, float x, float y, float w, float h) {
+    layers_[layer].boxes.push_back({e, x, y, x + w, y + h});
+}
+
+void SpatialGrid::build() {
+    const std::size_t cells = static_cast<std::size_t>(cols_) * static_cast<std::size_t>(rows_);
+    for (auto& l : layers_) {
+        // Count, prefix-sum, then scatter (cellStart doubles as the write cursor)
+        l.cellStart.assign(cells + 1, 0);
+        for (const Box& b : l.boxes) {
+            for (int cy = cellY(b.y0); cy <= cellY(b.y1); ++cy)
+                for (int cx = cellX(b.x0); cx <= cellX(b.x1); ++cx) ++l.cellStart[cy * cols_ + cx + 1];
+        }
+        for (std::size_t c = 0; c < cells; ++c) l.cellStart[c + 1] += l.cellStart[c];
+        l.cellItems.resize(l.cellStart[cells]);
+        for (std::uint32_t i = 0; i < l.boxes.size(); ++i) {
+            const Box& b = l.boxes[i];
+            for (int cy = cellY(b.y0); cy <= cellY(b.y1); ++cy)
+                for (int cx = cellX(b.x0); cx <= cellX(b.x1); ++cx) l.cellItems[l.cellStart[cy * cols_ + cx]++] = i;
+        }
+        // Scattering advanced every start to the next cell's start: shift back
+        for (std::size_t c = cells; c > 0; --c) l.cellStart[c] = l.cellStart[c - 1];
+        l.cellStart[0] = 0;
+        l.stamp.assign(l.boxes.size(), 0);
+    }
+    queryId_ = 0;
+}
+
+void SpatialGrid::query(Layer layer, float x, float y, float w, float h, std::vector<rt::ecs::Entity>& out) {
+    LayerData& l = layers_[layer];
+    if (l.boxes.empty()) return;
+    if (++queryId_ == 0) {
+        // Wrapped: forget every stamp so no box looks already visited
+        for (auto& ld : layers_) std::fill(ld.stamp.begin(), ld.stamp.end(), 0);
+        queryId_ = 1;
+    }
+    const float x1 = x + w, y1 = y + h;
+    hits_.clear();
+    for (int cy = cellY(y); cy <= cellY(y1); ++cy) {
+        for (int cx = cellX(x); cx <= cellX(x1); ++cx) {
+            const std::size_t c = static_cast<std::size_t>(cy * cols_ + cx);
+            for (std::uint32_t k = l.cellStart[c]; k < l.cellStart[c + 1]; ++k) {
+                std::uint32_t i = l.cellItems[k];
+                if (l.stamp[i] == queryId_) continue;
+                l.stamp[i] = queryId_;
+                ++pairTests_;
+                const Box& b = l.boxes[i];
+                if (!(x1 < b.x0 || b.x1 < x || y1 < b.y0 || b.y1 < y)) hits_.push_back(i);
+            }
+        }
+    }
+    bruteForceTests_ += l.boxes.size();
+    // Report in insertion order so results do not depend on cell layout
+    std::sort(hits_.begin(), hits_.end());
+    for (std::uint32_t i : hits_) out.push_back(l.boxes[i].e);
+}
@@ -1,18 +1,24 @@
 #include <cmath>
+#include <cstddef>
+#include <type_traits>
 #include <algorithm>
 #include <random>
 #include <limits>
+#include <memory>
 #include <vector>
 #include <iostream>
 #include "rt/game/Systems.hpp"
+#include "rt/math/Integrate.hpp"
 using namespace rt::game;
 
+bool InputSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<PlayerInput>().writes<Transform>();
+    return true;
+}
+
 void InputSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
-    auto& inputs = r.storage<PlayerInput>().data();
-    for (auto& [e, inp] : inputs) {
-        auto* t = r.get<Transform>(e);
-        if (!t) continue;
+    for (auto [e, inp, t] : r.view<PlayerInput, Transform>()) {
         float vx = 0.f, vy = 0.f;
         constexpr std::uint8_t kUp = 1 << 0;
         constexpr std::uint8_t kDown = 1 << 1;
@@ -23,115 +29,160 @@ void InputSystem::update(rt::ecs::Registry& r, float dt) {
         if (inp.bits & kUp)    vy -= inp.speed;
         if (inp.bits & kDown)  vy += inp.speed;
         // Directly integrate on transform (simple for now)
-        t->x += vx * dt;
-        t->y += vy * dt;
+        t.x += vx * dt;
+        t.y += vy * dt;
     }
 }
 
+bool MovementSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<Velocity>().writes<Transform>();
+    return true;
+}
+
+static_assert(std::is_standard_layout_v<Transform> && offsetof(Transform, y) == sizeof(float) &&
+                  sizeof(Transform) == 2 * sizeof(float),
+              "MovementSystem integrates Transform as a flat {x, y} float stream");
+static_assert(std::is_standard_layout_v<Velocity> && offsetof(Velocity, vy) == sizeof(float) &&
+                  sizeof(Velocity) == 2 * sizeof(float),
+              "MovementSystem integrates Velocity as a flat {vx, vy} float stream");
+
 void MovementSystem::update(rt::ecs::Registry& r, float dt) {
-    auto& vels = r.storage<Velocity>().data();
-    for (auto& [e, v] : vels) {
-        auto* t = r.get<Transform>(e);
-        if (!t) continue;
-        t->x += v.vx * dt;
-        t->y += v.vy * dt;
+    // Line transforms up with the velocity pool, then integrate the {x, y} and
+    // {vx, vy} runs in one vectorized pass
+    std::size_t n = r.align<Transform, Velocity>();
+    auto& ts = r.storage<Transform>();
+    auto& vs = r.storage<Velocity>();
+    if (n > 0) rt::math::integrate(&ts.components()[0].x, &vs.components()[0].vx, n * 2, dt);
+    // Velocities past the first one without a transform
+    for (std::size_t i = n; i < vs.size(); ++i) {
+        if (auto* t = ts.get(vs.entities()[i])) {
+            t->x += vs.components()[i].vx * dt;
+            t->y += vs.components()[i].vy * dt;
+        }
     }
 }
 
+bool ShootingSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<PlayerInput, Transform>().writes<Shooter>().structural();
+    return true;
+}
+
 void ShootingSystem::update(rt::ecs::Registry& r, float dt) {
-    // For every player with PlayerInput and Shooter, spawn bullets while holding shoot
-    auto& inputs = r.storage<PlayerInput>().data();
+    // For every player with PlayerInput and Shooter, spawn bullets while holding shoot.
+    // Bullets are recorded in the command buffer and created once the loop is done.
+    auto& cmd = r.commands();
     constexpr std::uint8_t kShoot = 1 << 4;
-    for (auto& [e, inp] : inputs) {
-        auto* shooter = r.get<Shooter>(e);
-        auto* t = r.get<Transform>(e);
-        if (!shooter || !t) continue;
-        shooter->cooldown -= dt;
+    for (auto [e, inp, shooter, t] : r.view<PlayerInput, Shooter, Transform>()) {
+        shooter.cooldown -= dt;
         bool wantShoot = (inp.bits & kShoot) != 0;
-        while (wantShoot && shooter->cooldown <= 0.f) {
-            shooter->cooldown += shooter->interval;
+        while (wantShoot && shooter.cooldown <= 0.f) {
+            shooter.cooldown += shooter.interval;
             // Spawn a bullet entity slightly ahead of the player ship
-            auto b = r.create();
-            float bx = t->x + 20.f; // assuming player ship width ~20
-            float by = t->y + 5.f;  // center roughly
-            r.emplace<Transform>(b, {bx, by});
-            r.emplace<Velocity>(b, {shooter->bulletSpeed, 0.f});
-            r.emplace<NetType>(b, {static_cast<rtype::net::EntityType>(3)});
-            r.emplace<ColorRGBA>(b, {0xFFFF55FFu});
-            r.emplace<BulletTag>(b, {BulletFaction::Player});
-            r.emplace<BulletOwner>(b, {e});
-            r.emplace<Size>(b, {6.f, 3.f});
+            auto b = cmd.create();
+            float bx = t.x + 20.f; // assuming player ship width ~20
+            float by = t.y + 5.f;  // center roughly
+            cmd.emplace<Transform>(b, {bx, by});
+            cmd.emplace<Velocity>(b, {shooter.bulletSpeed, 0.f});
+            cmd.emplace<NetType>(b, {static_cast<rtype::net::EntityType>(3)});
+            cmd.emplace<ColorRGBA>(b, {0xFFFF55FFu});
+            cmd.emplace<BulletTag>(b, {BulletFaction::Player});
+            cmd.emplace<BulletOwner>(b, {e});
+            cmd.emplace<Size>(b, {6.f, 3.f});
         }
     }
 }
 
+bool ChargeShootingSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<PlayerInput, Transform>().writes<ChargeGun, BossTag, Score>().uses(&grid_).uses(&beams_).structural();
+    return true;
+}
+
 void ChargeShootingSystem::update(rt::ecs::Registry& r, float dt) {
-    (void)dt;
     constexpr std::uint8_t kCharge = 1 << 5; // must match Protocol InputCharge
-    auto& inputs = r.storage<PlayerInput>().data();
-    for (auto& [e, inp] : inputs) {
-        auto* t = r.get<Transform>(e);
-        if (!t) continue;
-        auto* cg = r.get<ChargeGun>(e);
-        if (!cg) continue; // optional feature per player
+    constexpr float kWorldRight = 1000.f;   // same bound as bullet despawn
+    constexpr int kBossDamageMax = 20;      // boss hp taken by a fully charged beam
+    auto& cmd = r.commands();
+    // Destroys only land after the system, so an enemy hit by two beams this tick
+    // is still in the grid for the second one: score and destroy it once
+    killed_.clear();
+    auto kill = [&](rt::ecs::Entity enemy) {
+        killed_.push_back(enemy);
+        cmd.destroy(enemy);
+    };
+    // ChargeGun is an optional feature per player
+    for (auto [e, inp, cg, t] : r.view<PlayerInput, ChargeGun, Transform>()) {
         bool holding = (inp.bits & kCharge) != 0;
         if (holding) {
-            cg->charge = std::min(cg->maxCharge, cg->charge + dt);
+            cg.charge = std::min(cg.maxCharge, cg.charge + dt);
         } else {
-            if (cg->charge > 0.05f) {
+            if (cg.charge > 0.05f) {
                 // Fire beam once, thickness based on charge
-                float thickness = 8.f + (cg->charge / cg->maxCharge) * 44.f; // 8..52
-                auto b = r.create();
-                float bx = t->x + 10.f; // from player
-                float by = t->y + 6.f;  // centered on player
-                r.emplace<Transform>(b, {bx, by - thickness * 0.5f});
-                // Beam is instant; represent as a wide, slow-moving rectangle that lives one tick
-                r.emplace<Velocity>(b, {600.f, 0.f});
-                r.emplace<NetType>(b, {static_cast<rtype::net::EntityType>(3)});
-                r.emplace<ColorRGBA>(b, {0x77CCFFFFu});
-                r.emplace<BulletTag>(b, {BulletFaction::Player});
-                r.emplace<BulletOwner>(b, {e});
-                r.emplace<Size>(b, {700.f, thickness});
-                r.emplace<BeamTag>(b, {});
+                float ratio = cg.charge / cg.maxCharge;
+                float thickness = 8.f + ratio * 44.f; // 8..52
+                float bx = t.x + 10.f; // from player
+                float by = t.y + 6.f;  // centered on player
+                float length = std::max(0.f, kWorldRight - bx);
+                // Everything overlapping the beam is hit right now, this tick
+                hits_.clear();
+                grid_.query(SpatialGrid::Enemies, bx, by - thickness * 0.5f, length, thickness, hits_);
+                auto* sc = r.get<Score>(e);
+                for (auto enemy : hits_) {
+                    if (std::find(killed_.begin(), killed_.end(), enemy) != killed_.end()) continue;
+                    if (auto* boss = r.get<BossTag>(enemy)) {
+                        if (boss->hp <= 0) continue;
+                        boss->hp = std::max(0, boss->hp - (1 + static_cast<int>(ratio * (kBossDamageMax - 1))));
+                        if (boss->hp <= 0) {
+                            if (sc) sc->value += 1000;
+                            kill(enemy);
+                        }
+                        continue;
+                    }
+                    if (sc) sc->value += 50;
+                    kill(enemy);
+                }
+                beams_.push_back({e, bx, by, length, thickness});
                 // Reset charge
-                cg->charge = 0.f;
+                cg.charge = 0.f;
             }
         }
     }
 }
 
+bool EnemyShootingSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<NetType, Transform>().writes<EnemyShooter>().uses(&rng_).structural();
+    return true;
+}
+
 // Enemy shooting towards nearest player with variable accuracy
 void EnemyShootingSystem::update(rt::ecs::Registry& r, float dt) {
     // Build a list of players
     std::vector<rt::ecs::Entity> players;
-    for (auto& [e, nt] : r.storage<NetType>().data()) {
+    for (auto [e, nt] : r.storage<NetType>().data()) {
         if (nt.type == rtype::net::EntityType::Player) players.push_back(e);
     }
     if (players.empty()) return;
 
     // Update each enemy with EnemyShooter
-    auto& shooters = r.storage<EnemyShooter>().data();
-    for (auto& [e, es] : shooters) {
+    auto& cmd = r.commands();
+    for (auto [e, es, t] : r.view<EnemyShooter, Transform>()) {
         es.cooldown -= dt;
         if (es.cooldown > 0.f) continue;
-        auto* t = r.get<Transform>(e);
-        if (!t) continue;
         // Find nearest player
         rt::ecs::Entity best = players[0];
         float bestDist2 = std::numeric_limits<float>::infinity();
         for (auto p : players) {
             auto* pt = r.get<Transform>(p);
             if (!pt) continue;
-            float dx = pt->x - t->x;
-            float dy = pt->y - t->y;
+            float dx = pt->x - t.x;
+            float dy = pt->y - t.y;
             float d2 = dx*dx + dy*dy;
             if (d2 < bestDist2) { bestDist2 = d2; best = p; }
         }
         auto* pt = r.get<Transform>(best);
         if (!pt) continue;
         // Compute direction with inaccuracy
-        float dx = pt->x - t->x;
-        float dy = pt->y - t->y;
+        float dx = pt->x - t.x;
+        float dy = pt->y - t.y;
         float len = std::sqrt(dx*dx + dy*dy);
         if (len < 1e-3f) { dx = 1.f; dy = 0.f; len = 1.f; }
         dx /= len; dy /= len;
@@ -145,38 +196,34 @@ void EnemyShootingSystem::update(rt::ecs::Registry& r, float dt) {
         float dirx = dx * cs - dy * sn;
         float diry = dx * sn + dy * cs;
         // Spawn bullet
-        auto b = r.create();
-        float bx = t->x - 10.f; // from enemy front
-        float by = t->y + 6.f;
-        r.emplace<Transform>(b, {bx, by});
-        r.emplace<Velocity>(b, {dirx * es.bulletSpeed, diry * es.bulletSpeed});
-        r.emplace<NetType>(b, {static_cast<rtype::net::EntityType>(3)});
-        r.emplace<ColorRGBA>(b, {0xFFAA00FFu});
-        r.emplace<BulletTag>(b, {BulletFaction::Enemy});
-        r.emplace<Size>(b, {6.f, 3.f});
+        auto b = cmd.create();
+        float bx = t.x - 10.f; // from enemy front
+        float by = t.y + 6.f;
+        cmd.emplace<Transform>(b, {bx, by});
+        cmd.emplace<Velocity>(b, {dirx * es.bulletSpeed, diry * es.bulletSpeed});
+        cmd.emplace<NetType>(b, {static_cast<rtype::net::EntityType>(3)});
+        cmd.emplace<ColorRGBA>(b, {0xFFAA00FFu});
+        cmd.emplace<BulletTag>(b, {BulletFaction::Enemy});
+        cmd.emplace<Size>(b, {6.f, 3.f});
         es.cooldown += es.interval;
     }
 }
 
+bool FormationSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<Formation, FormationFollower, Size>().writes<Transform, Velocity>();
+    return true;
+}
+
 void FormationSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
     float time = t_ ? *t_ : 0.f;
-    // Move formation origins and compute follower world positions
-    auto& forms = r.storage<Formation>().data();
-    for (auto& [origin, f] : forms) {
-        // origin moves using its velocity if present
-        if (auto* v = r.get<Velocity>(origin)) {
-            if (auto* t = r.get<Transform>(origin)) {
-                t->x += v->vx * dt;
-                t->y += v->vy * dt;
-            }
-        }
+    // Move formation origins (those with a velocity) and compute follower world positions
+    for (auto [origin, f, v, t] : r.view<Formation, Velocity, Transform>()) {
+        t.x += v.vx * dt;
+        t.y += v.vy * dt;
     }
     // Update followers
-    auto& followers = r.storage<FormationFollower>().data();
-    for (auto& [e, ff] : followers) {
-        auto* t = r.get<Transform>(e);
-        if (!t) continue;
+    for (auto [e, ff, t] : r.view<FormationFollower, Transform>()) {
         auto* fo = r.get<Formation>(ff.formation);
         auto* tor = r.get<Transform>(ff.formation);
         if (!fo || !tor) continue;
@@ -207,109 +254,117 @@ void FormationSystem::update(rt::ecs::Registry& r, float dt) {
             // If size unknown, still keep roughly within screen
             y = std::clamp(y, kTopMargin, kWorldH - kBottomMargin);
         }
-        t->x = x; t->y = y;
+        t.x = x; t.y = y;
         // inherit velocity for serialization
         if (auto* v = r.get<Velocity>(e)) v->vx = -std::abs(fo->speedX);
     }
 }
 
+bool DespawnOffscreenSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<Transform>().structural();
+    return true;
+}
+
 void DespawnOffscreenSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
-    std::vector<rt::ecs::Entity> toDestroy;
-    auto& transforms = r.storage<Transform>().data();
-    for (auto& [e, t] : transforms) {
+    auto& cmd = r.commands();
+    for (auto [e, t] : r.storage<Transform>()) {
         if (t.x < minX_) {
-            toDestroy.push_back(e);
+            cmd.destroy(e);
         }
     }
-    for (auto e : toDestroy) r.destroy(e);
+}
+
+bool DespawnOutOfBoundsSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<BulletTag, Transform, Size>().structural();
+    return true;
 }
 
 void DespawnOutOfBoundsSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
-    std::vector<rt::ecs::Entity> toDestroy;
-    auto& transforms = r.storage<Transform>().data();
-    for (auto& [e, t] : transforms) {
-        // Only consider bullets for out-of-bounds despawn to avoid killing players
-        if (!r.get<BulletTag>(e)) continue;
+    auto& cmd = r.commands();
+    // Only consider bullets for out-of-bounds despawn to avoid killing players
+    for (auto [e, bt, t] : r.view<BulletTag, Transform>()) {
         auto* sz = r.get<Size>(e);
         float w = sz ? sz->w : 0.f;
         float h = sz ? sz->h : 0.f;
         if (t.x + w < minX_ || t.x > maxX_ || t.y + h < minY_ || t.y > maxY_) {
-            toDestroy.push_back(e);
+            cmd.destroy(e);
         }
     }
-    for (auto e : toDestroy) r.destroy(e);
 }
 
 // --- Spawn formations ---
 rt::ecs::Entity FormationSpawnSystem::spawnSnake(rt::ecs::Registry& r, float y, int count) {
-    auto origin = r.create();
-    r.emplace<Transform>(origin, {980.f, y});
-    r.emplace<Velocity>(origin, {-60.f, 0.f});
-    r.emplace<Formation>(origin, {FormationType::Snake, -60.f, 70.f, 2.5f, 36.f, 0, 0});
+    auto& cmd = r.commands();
+    auto origin = cmd.create();
+    cmd.emplace<Transform>(origin, {980.f, y});
+    cmd.emplace<Velocity>(origin, {-60.f, 0.f});
+    cmd.emplace<Formation>(origin, {FormationType::Snake, -60.f, 70.f, 2.5f, 36.f, 0, 0});
     std::uniform_int_distribution<int> chance(0, 99);
     for (int i = 0; i < count; ++i) {
-        auto e = r.create();
-        r.emplace<Transform>(e, {980.f + i * 36.f, y});
-        r.emplace<Velocity>(e, {-60.f, 0.f});
-        r.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
-        r.emplace<ColorRGBA>(e, {0xFF5555FFu});
-        r.emplace<EnemyTag>(e, {});
-        r.emplace<Size>(e, {27.f, 18.f});
-        r.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(i), i * 36.f, 0.f});
+        auto e = cmd.create();
+        cmd.emplace<Transform>(e, {980.f + i * 36.f, y});
+        cmd.emplace<Velocity>(e, {-60.f, 0.f});
+        cmd.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
+        cmd.emplace<ColorRGBA>(e, {0xFF5555FFu});
+        cmd.emplace<EnemyTag>(e, {});
+        cmd.emplace<Size>(e, {27.f, 18.f});
+        cmd.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(i), i * 36.f, 0.f}, &FormationFollower::formation);
         if (chance(rng_) < (int)shooterPercent_) {
             // attach enemy shooter with interval scaled by difficulty
             float interval = (difficulty_ == 2 ? 0.9f : difficulty_ == 1 ? 1.2f : 1.6f);
-            r.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 240.f, 0.65f});
+            cmd.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 240.f, 0.65f});
         }
     }
     return origin;
 }
 
 rt::ecs::Entity FormationSpawnSystem::spawnLine(rt::ecs::Registry& r, float y, int count) {
-    auto origin = r.create();
-    r.emplace<Transform>(origin, {980.f, y});
-    r.emplace<Velocity>(origin, {-60.f, 0.f});
-    r.emplace<Formation>(origin, {FormationType::Line, -60.f, 0.f, 0.f, 40.f, 0, 0});
+    auto& cmd = r.commands();
+    auto origin = cmd.create();
+    cmd.emplace<Transform>(origin, {980.f, y});
+    cmd.emplace<Velocity>(origin, {-60.f, 0.f});
+    cmd.emplace<Formation>(origin, {FormationType::Line, -60.f, 0.f, 0.f, 40.f, 0, 0});
     std::uniform_int_distribution<int> chance(0, 99);
     for (int i = 0; i < count; ++i) {
-        auto e = r.create();
-        r.emplace<Transform>(e, {980.f + i * 40.f, y});
-        r.emplace<Velocity>(e, {-60.f, 0.f});
-    r.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
-        r.emplace<ColorRGBA>(e, {0xE06666FFu});
-        r.emplace<EnemyTag>(e, {});
-        r.emplace<Size>(e, {27.f, 18.f});
-        r.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(i), i * 40.f, 0.f});
+        auto e = cmd.create();
+        cmd.emplace<Transform>(e, {980.f + i * 40.f, y});
+        cmd.emplace<Velocity>(e, {-60.f, 0.f});
+    cmd.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
+        cmd.emplace<ColorRGBA>(e, {0xE06666FFu});
+        cmd.emplace<EnemyTag>(e, {});
+        cmd.emplace<Size>(e, {27.f, 18.f});
+        cmd.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(i), i * 40.f, 0.f}, &FormationFollower::formation);
         if (chance(rng_) < (int)shooterPercent_) {
             float interval = (difficulty_ == 2 ? 0.9f : difficulty_ == 1 ? 1.2f : 1.6f);
-            r.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 240.f, 0.62f});
+            cmd.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 240.f, 0.62f});
         }
     }
     return origin;
 }
 
 rt::ecs::Entity FormationSpawnSystem::spawnGrid(rt::ecs::Registry& r, float y, int rows, int cols) {
-    auto origin = r.create();
-    r.emplace<Transform>(origin, {980.f, y});
-    r.emplace<Velocity>(origin, {-50.f, 0.f});
-    r.emplace<Formation>(origin, {FormationType::GridRect, -50.f, 0.f, 0.f, 36.f, rows, cols});
+    auto& cmd = r.commands();
+    auto origin = cmd.create();
+    cmd.emplace<Transform>(origin, {980.f, y});
+    cmd.emplace<Velocity>(origin, {-50.f, 0.f});
+    cmd.emplace<Formation>(origin, {FormationType::GridRect, -50.f, 0.f, 0.f, 36.f, rows, cols});
     std::uniform_int_distribution<int> chance(0, 99);
     for (int rr = 0; rr < rows; ++rr) {
         for (int cc = 0; cc < cols; ++cc) {
             int idx = rr * cols + cc;
-            auto e = r.create();
-            r.emplace<Transform>(e, {980.f + cc * 36.f, y + rr * 36.f});
-            r.emplace<Velocity>(e, {-50.f, 0.f});
-            r.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
-            r.emplace<ColorRGBA>(e, {0xCC4444FFu});
-            r.emplace<EnemyTag>(e, {});
-            r.emplace<Size>(e, {27.f, 18.f});
-            r.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(idx), cc * 36.f, rr * 36.f});
+            auto e = cmd.create();
+            cmd.emplace<Transform>(e, {980.f + cc * 36.f, y + rr * 36.f});
+            cmd.emplace<Velocity>(e, {-50.f, 0.f});
+            cmd.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
+            cmd.emplace<ColorRGBA>(e, {0xCC4444FFu});
+            cmd.emplace<EnemyTag>(e, {});
+            cmd.emplace<Size>(e, {27.f, 18.f});
+            cmd.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(idx), cc * 36.f, rr * 36.f}, &FormationFollower::formation);
             if (chance(rng_) < (int)shooterPercent_) {
                 float interval = (difficulty_ == 2 ? 1.0f : difficulty_ == 1 ? 1.3f : 1.7f);
-                r.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 220.f, 0.60f});
+                cmd.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 220.f, 0.60f});
             }
         }
     }
@@ -317,10 +372,11 @@ rt::ecs::Entity FormationSpawnSystem::spawnGrid(rt::ecs::Registry& r, float y, i
 }
 
 rt::ecs::Entity FormationSpawnSystem::spawnTriangle(rt::ecs::Registry& r, float y, int rows) {
-    auto origin = r.create();
-    r.emplace<Transform>(origin, {980.f, y});
-    r.emplace<Velocity>(origin, {-55.f, 0.f});
-    r.emplace<Formation>(origin, {FormationType::Triangle, -55.f, 0.f, 0.f, 36.f, rows, 0});
+    auto& cmd = r.commands();
+    auto origin = cmd.create();
+    cmd.emplace<Transform>(origin, {980.f, y});
+    cmd.emplace<Velocity>(origin, {-55.f, 0.f});
+    cmd.emplace<Formation>(origin, {FormationType::Triangle, -55.f, 0.f, 0.f, 36.f, rows, 0});
     int idx = 0;
     // Left-pointing triangle: apex on the left, expanding columns to the right
     std::uniform_int_distribution<int> chance(0, 99);
@@ -328,19 +384,19 @@ rt::ecs::Entity FormationSpawnSystem::spawnTriangle(rt::ecs::Registry& r, float
         int count = cc + 1; // number of enemies in this column
         float startY = -0.5f * (count - 1) * 36.f; // center vertically per column
         for (int rr = 0; rr < count; ++rr) {
-            auto e = r.create();
+            auto e = cmd.create();
             float localX = cc * 36.f;
             float localY = startY + rr * 36.f;
-            r.emplace<Transform>(e, {980.f + localX, y + localY});
-            r.emplace<Velocity>(e, {-55.f, 0.f});
-            r.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
-            r.emplace<ColorRGBA>(e, {0xDD7777FFu});
-            r.emplace<EnemyTag>(e, {});
-            r.emplace<Size>(e, {27.f, 18.f});
-            r.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(idx++), localX, localY});
+            cmd.emplace<Transform>(e, {980.f + localX, y + localY});
+            cmd.emplace<Velocity>(e, {-55.f, 0.f});
+            cmd.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
+            cmd.emplace<ColorRGBA>(e, {0xDD7777FFu});
+            cmd.emplace<EnemyTag>(e, {});
+            cmd.emplace<Size>(e, {27.f, 18.f});
+            cmd.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(idx++), localX, localY}, &FormationFollower::formation);
             if (chance(rng_) < (int)shooterPercent_) {
                 float interval = (difficulty_ == 2 ? 1.0f : difficulty_ == 1 ? 1.3f : 1.7f);
-                r.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 220.f, 0.60f});
+                cmd.emplace<EnemyShooter>(e, EnemyShooter{0.f, interval, 220.f, 0.60f});
             }
         }
     }
@@ -349,30 +405,36 @@ rt::ecs::Entity FormationSpawnSystem::spawnTriangle(rt::ecs::Registry& r, float
 
 // Big enemies that also shoot at players
 rt::ecs::Entity FormationSpawnSystem::spawnBigShooters(rt::ecs::Registry& r, float y, int count) {
-    auto origin = r.create();
-    r.emplace<Transform>(origin, {980.f, y});
-    r.emplace<Velocity>(origin, {-40.f, 0.f});
-    r.emplace<Formation>(origin, {FormationType::Line, -40.f, 0.f, 0.f, 64.f, 0, 0});
+    auto& cmd = r.commands();
+    auto origin = cmd.create();
+    cmd.emplace<Transform>(origin, {980.f, y});
+    cmd.emplace<Velocity>(origin, {-40.f, 0.f});
+    cmd.emplace<Formation>(origin, {FormationType::Line, -40.f, 0.f, 0.f, 64.f, 0, 0});
     std::uniform_real_distribution<float> accd(0.5f, 0.8f);
     for (int i = 0; i < count; ++i) {
-        auto e = r.create();
+        auto e = cmd.create();
         float localX = i * 64.f;
-        r.emplace<Transform>(e, {980.f + localX, y});
-        r.emplace<Velocity>(e, {-40.f, 0.f});
-        r.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
-        r.emplace<ColorRGBA>(e, {0xAA3333FFu});
-        r.emplace<EnemyTag>(e, {});
-        r.emplace<Size>(e, {28.f, 20.f});
-        r.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(i), localX, 0.f});
-        r.emplace<EnemyShooter>(e, {0.f, 1.2f, 240.f, accd(rng_)});
+        cmd.emplace<Transform>(e, {980.f + localX, y});
+        cmd.emplace<Velocity>(e, {-40.f, 0.f});
+        cmd.emplace<NetType>(e, {static_cast<rtype::net::EntityType>(2)});
+        cmd.emplace<ColorRGBA>(e, {0xAA3333FFu});
+        cmd.emplace<EnemyTag>(e, {});
+        cmd.emplace<Size>(e, {28.f, 20.f});
+        cmd.emplace<FormationFollower>(e, {origin, static_cast<std::uint16_t>(i), localX, 0.f}, &FormationFollower::formation);
+        cmd.emplace<EnemyShooter>(e, {0.f, 1.2f, 240.f, accd(rng_)});
     }
     return origin;
 }
 
+bool FormationSpawnSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<BossTag, Formation>().uses(&rng_).structural();
+    return true;
+}
+
 void FormationSpawnSystem::update(rt::ecs::Registry& r, float dt) {
     // Suppress regular waves while a boss is active
     bool bossPresent = false;
-    for (auto& [e, _] : r.storage<BossTag>().data()) { (void)e; bossPresent = true; break; }
+    for (auto [e, _] : r.storage<BossTag>().data()) { (void)e; bossPresent = true; break; }
     if (bossPresent) {
         blockedByBoss_ = true;
         return;
@@ -389,7 +451,7 @@ void FormationSpawnSystem::update(rt::ecs::Registry& r, float dt) {
     timer_ = 0.f;
     // Limit to at most two active formations (origins)
     int activeFormations = 0;
-    for (auto& [e, _] : r.storage<Formation>().data()) { (void)e; ++activeFormations; }
+    for (auto [e, _] : r.storage<Formation>().data()) { (void)e; ++activeFormations; }
     if (activeFormations >= 2) return;
     // World and margins
     constexpr float kWorldH = 600.f;
@@ -481,114 +543,129 @@ void FormationSpawnSystem::update(rt::ecs::Registry& r, float dt) {
     }
 }
 
+bool BroadphaseSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<EnemyTag, PlayerInput, Transform, Size>().uses(&grid_);
+    return true;
+}
+
+void BroadphaseSystem::update(rt::ecs::Registry& r, float dt) {
+    (void)dt;
+    grid_.clear();
+    for (auto [e, tag, t, s] : r.view<EnemyTag, Transform, Size>()) grid_.insert(SpatialGrid::Enemies, e, t.x, t.y, s.w, s.h);
+    for (auto [e, inp, t, s] : r.view<PlayerInput, Transform, Size>()) grid_.insert(SpatialGrid::Players, e, t.x, t.y, s.w, s.h);
+    grid_.build();
+}
+
+bool CollisionSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<BulletTag, BulletOwner, PlayerInput, Transform, Size>()
+        .writes<BossTag, Score, HitFlag, Invincible>()
+        .uses(&grid_)
+        .structural();
+    return true;
+}
+
 void CollisionSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
-    // Gather bullets
-    std::vector<rt::ecs::Entity> bullets;
-    bullets.reserve(128);
-    for (auto& [e, _] : r.storage<BulletTag>().data()) bullets.push_back(e);
-
-    std::vector<rt::ecs::Entity> toDestroy;
-    auto intersects = [&](rt::ecs::Entity a, rt::ecs::Entity b){
-        auto* ta = r.get<Transform>(a); auto* sa = r.get<Size>(a);
-        auto* tb = r.get<Transform>(b); auto* sb = r.get<Size>(b);
-        if (!ta || !tb || !sa || !sb) return false;
-        float ax2 = ta->x + sa->w, ay2 = ta->y + sa->h;
-        float bx2 = tb->x + sb->w, by2 = tb->y + sb->h;
-        return !(ax2 < tb->x || bx2 < ta->x || ay2 < tb->y || by2 < ta->y);
+    // Destroys are deferred, so everything hit this frame still takes part in the remaining
+    // tests, and nothing moves here: the boxes cached by the broadphase stay exact
+    auto& cmd = r.commands();
+    // Invincibility granted this frame is only recorded, so remember who already got it
+    struck_.clear();
+    auto shielded = [&](rt::ecs::Entity p) {
+        if (auto* inv = r.get<Invincible>(p); inv && inv->timeLeft > 0.f) return true;
+        return std::find(struck_.begin(), struck_.end(), p) != struck_.end();
     };
 
     // Collide bullets with appropriate targets
-    for (auto b : bullets) {
-        auto* bt = r.get<BulletTag>(b);
-        if (!bt) continue;
-        bool isBeam = r.get<BeamTag>(b) != nullptr;
-        if (bt->faction == BulletFaction::Player) {
+    for (auto [b, bt, tb, sb] : r.view<BulletTag, Transform, Size>()) {
+        hits_.clear();
+        if (bt.faction == BulletFaction::Player) {
             // hit enemies
-            for (auto& [e, _] : r.storage<EnemyTag>().data()) {
-                if (!intersects(b, e)) continue;
+            grid_.query(SpatialGrid::Enemies, tb.x, tb.y, sb.w, sb.h, hits_);
+            for (auto e : hits_) {
+                if (!r.valid(e)) continue; // killed by a beam earlier this tick
                 if (auto* boss = r.get<BossTag>(e)) {
                     if (boss->hp > 0) boss->hp -= 1;
-                    if (!isBeam) toDestroy.push_back(b);
+                    cmd.destroy(b);
                     if (boss->hp <= 0) {
                         if (auto* bo = r.get<BulletOwner>(b)) if (auto* sc = r.get<Score>(bo->owner)) sc->value += 1000;
-                        toDestroy.push_back(e);
+                        cmd.destroy(e);
                     }
-                    if (!isBeam) break;
-                    else continue;
+                    break;
                 }
                 if (auto* bo = r.get<BulletOwner>(b)) {
                     if (auto* sc = r.get<Score>(bo->owner)) {
                         sc->value += 50;
                     }
                 }
-                if (!isBeam) toDestroy.push_back(b);
-                toDestroy.push_back(e);
-                if (!isBeam) break;
+                cmd.destroy(b);
+                cmd.destroy(e);
+                break;
             }
         } else {
-            // enemy bullets hit players
-            for (auto& [e, _] : r.storage<PlayerInput>().data()) {
-                // players have PlayerInput component
-                if (!intersects(b, e)) continue;
+            // enemy bullets hit players (players have PlayerInput component)
+            grid_.query(SpatialGrid::Players, tb.x, tb.y, sb.w, sb.h, hits_);
+            for (auto e : hits_) {
                 // If player is currently invincible, ignore this hit (but still destroy bullet)
-                if (auto* inv = r.get<Invincible>(e)) {
-                    if (inv->timeLeft > 0.f) { toDestroy.push_back(b); break; }
-                }
+                if (shielded(e)) { cmd.destroy(b); break; }
                 // Mark player as hit; server will process lives decrement
                 if (auto* hf = r.get<HitFlag>(e)) {
                     hf->value = true;
                 } else {
-                    r.emplace<HitFlag>(e, {true});
+                    cmd.emplace<HitFlag>(e, {true});
                 }
                 // Apply a brief invincibility to prevent immediate re-hits
                 if (auto* inv = r.get<Invincible>(e)) {
                     inv->timeLeft = std::max(inv->timeLeft, 1.0f);
                 } else {
-                    r.emplace<Invincible>(e, {1.0f});
+                    cmd.emplace<Invincible>(e, {1.0f});
+                    struck_.push_back(e);
                 }
-                toDestroy.push_back(b);
+                cmd.destroy(b);
                 break;
             }
         }
     }
 
     // Player-Enemy direct collision
-    for (auto& [player, _] : r.storage<PlayerInput>().data()) {
+    for (auto [player, inp, tp, sp] : r.view<PlayerInput, Transform, Size>()) {
         // Skip if player is invincible
-        if (auto* inv = r.get<Invincible>(player)) {
-            if (inv->timeLeft > 0.f) continue;
+        if (shielded(player)) continue;
+
+        hits_.clear();
+        grid_.query(SpatialGrid::Enemies, tp.x, tp.y, sp.w, sp.h, hits_);
+        auto it = std::find_if(hits_.begin(), hits_.end(), [&r](rt::ecs::Entity en) { return r.valid(en); });
+        if (it == hits_.end()) continue;
+        // Only one collision per player per frame
+        auto enemy = *it;
+        // Mark player as hit
+        if (auto* hf = r.get<HitFlag>(player)) {
+            hf->value = true;
+        } else {
+            cmd.emplace<HitFlag>(player, {true});
         }
-
-        for (auto& [enemy, __] : r.storage<EnemyTag>().data()) {
-            if (intersects(player, enemy)) {
-                // Mark player as hit
-                if (auto* hf = r.get<HitFlag>(player)) {
-                    hf->value = true;
-                } else {
-                    r.emplace<HitFlag>(player, {true});
-                }
-                // Apply brief invincibility
-                if (auto* inv = r.get<Invincible>(player)) {
-                    inv->timeLeft = std::max(inv->timeLeft, 1.0f);
-                } else {
-                    r.emplace<Invincible>(player, {1.0f});
-                }
-                // Destroy the enemy on collision
-                toDestroy.push_back(enemy);
-                break; // Only one collision per player per frame
-            }
+        // Apply brief invincibility
+        if (auto* inv = r.get<Invincible>(player)) {
+            inv->timeLeft = std::max(inv->timeLeft, 1.0f);
+        } else {
+            cmd.emplace<Invincible>(player, {1.0f});
+            struck_.push_back(player);
         }
+        // Destroy the enemy on collision
+        cmd.destroy(enemy);
     }
+}
 
-    for (auto e : toDestroy) r.destroy(e);
+bool InvincibilitySystem::declareAccess(rt::ecs::Access& a) const {
+    a.writes<Invincible>();
+    return true;
 }
 
 // Decrement invincibility timers each frame
 void InvincibilitySystem::update(rt::ecs::Registry& r, float dt) {
     // Tick invincibility
     auto& invs = r.storage<Invincible>().data();
-    for (auto& [e, inv] : invs) {
+    for (auto [e, inv] : invs) {
         inv.timeLeft -= dt;
         if (inv.timeLeft <= 0.f) {
             inv.timeLeft = 0.f;
@@ -600,13 +677,13 @@ void BossSpawnSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
     // Track whether a boss is currently present
     bool anyBoss = false;
-    for (auto& [e, _] : r.storage<BossTag>().data()) { (void)e; anyBoss = true; break; }
+    for (auto [e, _] : r.storage<BossTag>().data()) { (void)e; anyBoss = true; break; }
     bossActive_ = anyBoss;
     if (anyBoss) return;
 
     // No boss present: decide whether to spawn based on score threshold multiples
     int bestScore = 0;
-    for (auto& [e, sc] : r.storage<Score>().data()) { (void)e; bestScore = std::max(bestScore, sc.value); }
+    for (auto [e, sc] : r.storage<Score>().data()) { (void)e; bestScore = std::max(bestScore, sc.value); }
     if (threshold_ <= 0) return;
     int shouldHaveSpawned = bestScore / threshold_;
     if (shouldHaveSpawned <= bossesSpawned_) return; // not yet at next multiple
@@ -644,11 +721,11 @@ void BossSpawnSystem::update(rt::ecs::Registry& r, float dt) {
     bossActive_ = true;
 }
 
-void BossSystem::update(rt::ecs::Registry& r, float dt) {
+void BossSystem::update(rt::ecs::Registry& r, float) {
     constexpr float kWorldH = 600.f;
     constexpr float kTopMargin = 56.f;
     constexpr float kBottomMargin = 10.f;
-    for (auto& [e, boss] : r.storage<BossTag>().data()) {
+    for (auto [e, boss] : r.storage<BossTag>().data()) {
         auto* t = r.get<Transform>(e);
         auto* v = r.get<Velocity>(e);
         auto* s = r.get<Size>(e);
@@ -682,10 +759,16 @@ void BossSystem::update(rt::ecs::Registry& r, float dt) {
     }
 }
 
+bool PowerupSpawnSystem::declareAccess(rt::ecs::Access& a) const {
+    a.uses(&rng_).structural();
+    return true;
+}
+
 // Spawn power-ups based on score thresholds
 void PowerupSpawnSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
     if (!teamScore_) return;
+    auto& cmd = r.commands();
 
     // Spawn power-ups for every threshold crossed
     while (*teamScore_ >= nextPowerupScore_) {
@@ -706,12 +789,12 @@ void PowerupSpawnSystem::update(rt::ecs::Registry& r, float dt) {
         PowerupType type = static_cast<PowerupType>(tdist(rng_));
 
         // Create the power-up entity
-        auto pu = r.create();
-        r.emplace<Transform>(pu, Transform{x, y});
-        r.emplace<Velocity>(pu, Velocity{-powerupSpeed_, 0.f});
-        r.emplace<PowerupTag>(pu, PowerupTag{type});
-        r.emplace<NetType>(pu, NetType{rtype::net::EntityType::Powerup});
-        r.emplace<Size>(pu, Size{18.f, 18.f}); // radius ~9
+        auto pu = cmd.create();
+        cmd.emplace<Transform>(pu, Transform{x, y});
+        cmd.emplace<Velocity>(pu, Velocity{-powerupSpeed_, 0.f});
+        cmd.emplace<PowerupTag>(pu, PowerupTag{type});
+        cmd.emplace<NetType>(pu, NetType{rtype::net::EntityType::Powerup});
+        cmd.emplace<Size>(pu, Size{18.f, 18.f}); // radius ~9
 
         // Set color based on type
         std::uint32_t color = 0xFFFFFFFF;
@@ -721,7 +804,7 @@ void PowerupSpawnSystem::update(rt::ecs::Registry& r, float dt) {
             case PowerupType::ClearBoard:    color = 0xAA50C8FF; break; // purple
             case PowerupType::InfiniteFire:  color = 0xF0DC50FF; break; // yellow
         }
-        r.emplace<ColorRGBA>(pu, ColorRGBA{color});
+        cmd.emplace<ColorRGBA>(pu, ColorRGBA{color});
 
         // Schedule next power-up
         std::uniform_int_distribution<int> dd(powerupMinPts_, powerupMaxPts_);
@@ -729,92 +812,81 @@ void PowerupSpawnSystem::update(rt::ecs::Registry& r, float dt) {
     }
 }
 
+bool PowerupCollisionSystem::declareAccess(rt::ecs::Access& a) const {
+    a.reads<PowerupTag, EnemyTag, LifePickup, Transform, Size>()
+        .writes<Invincible, InfiniteFire, Score>()
+        .uses(&grid_)
+        .structural();
+    return true;
+}
+
 // Handle power-up collision with players
 void PowerupCollisionSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
-    std::vector<rt::ecs::Entity> toDestroy;
-
-    // Helper to check AABB collision
-    auto intersects = [&r](rt::ecs::Entity a, rt::ecs::Entity b) -> bool {
-        auto* ta = r.get<Transform>(a);
-        auto* sa = r.get<Size>(a);
-        auto* tb = r.get<Transform>(b);
-        auto* sb = r.get<Size>(b);
-        if (!ta || !sa || !tb || !sb) return false;
-        float ax1 = ta->x, ay1 = ta->y, ax2 = ta->x + sa->w, ay2 = ta->y + sa->h;
-        float bx1 = tb->x, by1 = tb->y, bx2 = tb->x + sb->w, by2 = tb->y + sb->h;
-        return !(ax2 < bx1 || bx2 < ax1 || ay2 < by1 || by2 < ay1);
-    };
-
-    // Check each power-up against all players
-    auto& powerups = r.storage<PowerupTag>().data();
-    for (auto& [pu, tag] : powerups) {
-        bool collected = false;
-
-        for (auto& [player, _] : r.storage<PlayerInput>().data()) {
-            if (intersects(pu, player)) {
-                // Apply power-up effect
-                switch (tag.type) {
-                    case PowerupType::Life: {
-                        // Mark that this player should receive an extra life
-                        if (!r.get<LifePickup>(player)) {
-                            r.emplace<LifePickup>(player, LifePickup{true});
-                        }
-                        break;
-                    }
-                    case PowerupType::Invincibility: {
-                        // Grant 10 seconds of invincibility
-                        if (auto* inv = r.get<Invincible>(player)) {
-                            inv->timeLeft = std::max(inv->timeLeft, 10.0f);
-                        } else {
-                            r.emplace<Invincible>(player, Invincible{10.0f});
-                        }
-                        break;
-                    }
-                    case PowerupType::ClearBoard: {
-                        // Destroy all enemies on screen and award points
-                        std::vector<rt::ecs::Entity> enemiesToDestroy;
-                        for (auto& [e, _] : r.storage<EnemyTag>().data()) {
-                            enemiesToDestroy.push_back(e);
-                        }
-                        for (auto e : enemiesToDestroy) {
-                            toDestroy.push_back(e);
-                        }
-                        // Award score for cleared enemies
-                        if (auto* sc = r.get<Score>(player)) {
-                            sc->value += 50 * static_cast<int>(enemiesToDestroy.size());
-                        }
-                        break;
-                    }
-                    case PowerupType::InfiniteFire: {
-                        // Grant 10 seconds of infinite fire
-                        if (auto* inf = r.get<InfiniteFire>(player)) {
-                            inf->timeLeft = std::max(inf->timeLeft, 10.0f);
-                        } else {
-                            r.emplace<InfiniteFire>(player, InfiniteFire{10.0f});
-                        }
-                        break;
-                    }
+    auto& cmd = r.commands();
+
+    // Check each power-up against the players in the broadphase grid
+    for (auto [pu, tag, t, sz] : r.view<PowerupTag, Transform, Size>()) {
+        hits_.clear();
+        grid_.query(SpatialGrid::Players, t.x, t.y, sz.w, sz.h, hits_);
+        if (hits_.empty()) continue;
+        // First player touching it collects it
+        auto player = hits_.front();
+
+        // Apply power-up effect
+        switch (tag.type) {
+            case PowerupType::Life: {
+                // Mark that this player should receive an extra life
+                if (!r.get<LifePickup>(player)) {
+                    cmd.emplace<LifePickup>(player, LifePickup{true});
+                }
+                break;
+            }
+            case PowerupType::Invincibility: {
+                // Grant 10 seconds of invincibility
+                if (auto* inv = r.get<Invincible>(player)) {
+                    inv->timeLeft = std::max(inv->timeLeft, 10.0f);
+                } else {
+                    cmd.emplace<Invincible>(player, Invincible{10.0f});
+                }
+                break;
+            }
+            case PowerupType::ClearBoard: {
+                // Destroy all enemies on screen and award points
+                auto& enemies = r.storage<EnemyTag>();
+                for (auto [e, _] : enemies) {
+                    cmd.destroy(e);
+                }
+                // Award score for cleared enemies
+                if (auto* sc = r.get<Score>(player)) {
+                    sc->value += 50 * static_cast<int>(enemies.size());
+                }
+                break;
+            }
+            case PowerupType::InfiniteFire: {
+                // Grant 10 seconds of infinite fire
+                if (auto* inf = r.get<InfiniteFire>(player)) {
+                    inf->timeLeft = std::max(inf->timeLeft, 10.0f);
+                } else {
+                    cmd.emplace<InfiniteFire>(player, InfiniteFire{10.0f});
                 }
-
-                collected = true;
-                toDestroy.push_back(pu);
                 break;
             }
         }
 
-        if (collected) continue;
+        cmd.destroy(pu);
     }
+}
 
-    for (auto e : toDestroy) {
-        r.destroy(e);
-    }
+bool InfiniteFireSystem::declareAccess(rt::ecs::Access& a) const {
+    a.writes<InfiniteFire, Shooter>();
+    return true;
 }
 
 // Manage infinite fire timers and modify shooting behavior
 void InfiniteFireSystem::update(rt::ecs::Registry& r, float dt) {
     auto& fires = r.storage<InfiniteFire>().data();
-    for (auto& [e, inf] : fires) {
+    for (auto [e, inf] : fires) {
         inf.timeLeft -= dt;
         if (inf.timeLeft <= 0.f) {
             inf.timeLeft = 0.f;
@@ -829,3 +901,24 @@ void InfiniteFireSystem::update(rt::ecs::Registry& r, float dt) {
     }
 }
 
+void rt::game::addMatchSystems(rt::ecs::Registry& r, SpatialGrid& grid, std::vector<BeamEvent>& beams,
+                               std::mt19937& rng, float* elapsed, std::int32_t* teamScore) {
+    // Timers tick before the shooters read them
+    r.addSystem(std::make_unique<InputSystem>());
+    r.addSystem(std::make_unique<InvincibilitySystem>());
+    r.addSystem(std::make_unique<InfiniteFireSystem>());
+    r.addSystem(std::make_unique<ShootingSystem>());
+    r.addSystem(std::make_unique<FormationSystem>(elapsed));
+    r.addSystem(std::make_unique<FormationSpawnSystem>(rng, elapsed));
+    r.addSystem(std::make_unique<MovementSystem>());
+    // Powerups appear after movement, as they did when spawned at the end of the tick
+    r.addSystem(std::make_unique<PowerupSpawnSystem>(rng, teamScore));
+    r.addSystem(std::make_unique<EnemyShootingSystem>(rng));
+    r.addSystem(std::make_unique<DespawnOffscreenSystem>(-50.f));
+    // The grid only holds enemies and players, so it can be built while bullets despawn
+    r.addSystem(std::make_unique<BroadphaseSystem>(grid));
+    r.addSystem(std::make_unique<DespawnOutOfBoundsSystem>(-50.f, 1000.f, -50.f, 600.f));
+    r.addSystem(std::make_unique<ChargeShootingSystem>(grid, beams));
+    r.addSystem(std::make_unique<CollisionSystem>(grid));
+    r.addSystem(std::make_unique<PowerupCollisionSystem>(grid));
+}
@@ -0,0 +1,44 @@
+#include "rt/math/Integrate.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RT_INTEGRATE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RT_INTEGRATE_SSE2 1
+#endif
+
+namespace rt::math {
+
+void integrate(float* pos, const float* vel, std::size_t count, float dt) {
+    std::size_t i = 0;
+#if defined(RT_INTEGRATE_AVX2)
+    const __m256 vdt = _mm256_set1_ps(dt);
+    for (; i + 8 <= count; i += 8) {
+        __m256 p = _mm256_loadu_ps(pos + i);
+        __m256 v = _mm256_loadu_ps(vel + i);
+        _mm256_storeu_ps(pos + i, _mm256_add_ps(p, _mm256_mul_ps(v, vdt)));
+    }
+#elif defined(RT_INTEGRATE_SSE2)
+    const __m128 vdt = _mm_set1_ps(dt);
+    for (; i + 4 <= count; i += 4) {
+        __m128 p = _mm_loadu_ps(pos + i);
+        __m128 v = _mm_loadu_ps(vel + i);
+        _mm_storeu_ps(pos + i, _mm_add_ps(p, _mm_mul_ps(v, vdt)));
+    }
+#endif
+    // Tail (or everything without SIMD)
+    for (; i < count; ++i) pos[i] += vel[i] * dt;
+}
+
+const char* integrateBackend() {
+#if defined(RT_INTEGRATE_AVX2)
+    return "avx2";
+#elif defined(RT_INTEGRATE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+}
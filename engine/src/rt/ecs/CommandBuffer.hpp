@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "rt/ecs/Types.hpp"
+
+namespace rt::ecs {
+
+class Registry;
+
+// Records structural changes (create/emplace/remove/destroy) so systems can
+// keep iterating storages while they spawn and despawn; the registry plays the
+// buffer back at sync points (after each system in Registry::update).
+//
+// create() returns a placeholder handle that is only meaningful to this buffer:
+// use it as the target of later commands. It may only be stored inside a
+// component through the emplace overload naming that member, which resolves it.
+// Component values are copied into a byte arena, so they must be trivially
+// copyable. Destroys are applied last, as one batch.
+class CommandBuffer {
+  public:
+    Entity create() {
+        Entity e = makeEntity(created_++, kPlaceholderVersion);
+        cmds_.push_back({Op::Create, e, nullptr, 0, kNoRef});
+        return e;
+    }
+
+    template <typename C>
+    void emplace(Entity e, const C& c = C{}) {
+        static_assert(std::is_trivially_copyable_v<C>, "CommandBuffer stores components by memcpy");
+        auto offset = static_cast<std::uint32_t>(payload_.size());
+        payload_.resize(payload_.size() + sizeof(C));
+        std::memcpy(payload_.data() + offset, &c, sizeof(C));
+        cmds_.push_back({Op::Emplace, e, &applyEmplace<C>, offset, kNoRef});
+    }
+
+    // Same, with the handle member `ref` of `c` rewritten to the real entity at
+    // playback when it is a placeholder of this buffer (e.g. a follower pointing
+    // at a formation origin recorded just before it)
+    template <typename C>
+    void emplace(Entity e, const C& c, Entity C::*ref) {
+        emplace<C>(e, c);
+        cmds_.back().ref = static_cast<std::uint32_t>(reinterpret_cast<const std::byte*>(&(c.*ref)) -
+                                                      reinterpret_cast<const std::byte*>(&c));
+    }
+
+    template <typename C>
+    void remove(Entity e) { cmds_.push_back({Op::Remove, e, &applyRemove<C>, 0, kNoRef}); }
+
+    void destroy(Entity e) { cmds_.push_back({Op::Destroy, e, nullptr, 0, kNoRef}); }
+
+    // Plays the commands back in record order and clears the buffer. Commands
+    // aimed at entities that are no longer alive are dropped. Defined in Registry.hpp.
+    void flush(Registry& r);
+
+    bool empty() const { return cmds_.empty(); }
+    std::size_t size() const { return cmds_.size(); }
+
+    // Keeps the capacity for the next round
+    void clear() {
+        cmds_.clear();
+        payload_.clear();
+        created_ = 0;
+    }
+
+    static constexpr bool isPlaceholder(Entity e) { return entityVersion(e) == kPlaceholderVersion; }
+
+  private:
+    enum class Op : std::uint8_t { Create, Emplace, Remove, Destroy };
+    using ApplyFn = void (*)(Registry&, Entity, const std::byte*);
+
+    static constexpr std::uint32_t kNoRef = ~std::uint32_t{0};
+
+    struct Command {
+        Op op;
+        Entity e;
+        ApplyFn apply;
+        std::uint32_t offset;
+        std::uint32_t ref; // byte offset of a handle to resolve inside the payload, or kNoRef
+    };
+
+    template <typename C>
+    static void applyEmplace(Registry& r, Entity e, const std::byte* payload);
+    template <typename C>
+    static void applyRemove(Registry& r, Entity e, const std::byte* payload);
+
+    std::vector<Command> cmds_;
+    std::vector<std::byte> payload_;
+    Entity created_ = 0;
+    // Playback scratch, kept to avoid reallocating every flush
+    std::vector<Entity> resolved_;
+    std::vector<Entity> destroyed_;
+};
+
+}
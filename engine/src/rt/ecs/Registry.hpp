@@ -1,12 +1,18 @@
 #pragma once
-#include <unordered_map>
-#include <typeindex>
 #include <memory>
 #include <vector>
 #include <algorithm>
 #include <utility>
+#include <stdexcept>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
 #include "rt/ecs/Types.hpp"
 #include "rt/ecs/Storage.hpp"
+#include "rt/ecs/View.hpp"
+#include "rt/ecs/CommandBuffer.hpp"
+#include "rt/ecs/Scheduler.hpp"
 #include "rt/ecs/System.hpp"
 
 namespace rt::ecs {
@@ -31,8 +37,35 @@ class EntityHandle {
 
 class Registry {
   public:
+    // Component types get one signature bit each (componentFamily), process-wide
+    static constexpr std::size_t kMaxComponentTypes = 64;
+
+    // Freed indices are reused oldest first (with their bumped version), and only
+    // once kMinFreeIndices are queued: a given index comes back at most once every
+    // kMinFreeIndices destroys, so its 12-bit version takes long to wrap to a handle
+    // still held somewhere.
+    static constexpr std::size_t kMinFreeIndices = 1024;
+
     EntityHandle create() {
-        Entity e = ++last_;
+        Entity e;
+        if (freeCount_ > kMinFreeIndices) {
+            Entity idx = freeHead_;
+            freeHead_ = entityIndex(slots_[idx]);
+            if (freeHead_ == 0) freeTail_ = 0;
+            --freeCount_;
+            e = makeEntity(idx, entityVersion(slots_[idx]));
+        } else {
+            if (slots_.size() > kEntityIndexMask)
+                throw std::length_error("rt::ecs::Registry: entity index space exhausted");
+            e = makeEntity(static_cast<Entity>(slots_.size()), 0);
+            slots_.push_back(e);
+            signatures_.push_back(0);
+            alivePos_.push_back(0);
+        }
+        Entity idx = entityIndex(e);
+        slots_[idx] = e;
+        signatures_[idx] = 0;
+        alivePos_[idx] = static_cast<std::uint32_t>(alive_.size());
         alive_.push_back(e);
         return EntityHandle(*this, e);
     }
@@ -41,33 +74,102 @@ class Registry {
 
     EntityHandle handle(Entity e) { return EntityHandle(*this, e); }
 
+    // True while `e` is the current generation of its slot (O(1))
+    bool valid(Entity e) const {
+        Entity idx = entityIndex(e);
+        return idx != 0 && idx < slots_.size() && slots_[idx] == e;
+    }
+
+    // Bitmask of the component pools `e` has been emplaced into
+    Signature signature(Entity e) const { return valid(e) ? signatures_[entityIndex(e)] : 0; }
+
+    // Only visits the pools named in the entity signature.
+    // Destroying a stale or already destroyed handle is a no-op.
     void destroy(Entity e) {
-        for (auto& [_, store] : stores_) store->remove(e);
-        alive_.erase(std::remove(alive_.begin(), alive_.end(), e), alive_.end());
+        if (!valid(e)) return;
+        Signature sig = signatures_[entityIndex(e)];
+        release(e);
+        for (; sig; sig &= sig - 1) pools_[std::countr_zero(sig)]->remove(e);
     }
 
+    // Batch form: slots are released first (which also drops duplicates and stale
+    // handles), then each touched pool removes the whole batch in one call.
+    void destroy(std::span<const Entity> batch) {
+        Signature touched = 0;
+        batch_.clear();
+        for (Entity e : batch) {
+            if (!valid(e)) continue;
+            touched |= signatures_[entityIndex(e)];
+            release(e);
+            batch_.push_back(e);
+        }
+        for (; touched; touched &= touched - 1) pools_[std::countr_zero(touched)]->removeMany(batch_);
+    }
+
+    // Fast path is one indexed load; the pool is created on first use
     template <typename C>
     ComponentStorage<C>& storage() {
-        auto key = std::type_index(typeid(C));
-        auto it = stores_.find(key);
-        if (it == stores_.end()) {
-            auto ptr = std::make_unique<ComponentStorage<C>>();
-            auto raw = ptr.get();
-            stores_.emplace(key, std::move(ptr));
-            return *raw;
-        }
-        return *static_cast<ComponentStorage<C>*>(it->second.get());
+        std::size_t id = componentFamily<C>();
+        if (id < pools_.size() && pools_[id]) return pool<C>(id);
+        return pool<C>(poolId<C>());
     }
 
+    // `e` must be alive: a stale handle would tag and overwrite whoever owns its
+    // index now. Asserted in debug builds; in release builds nothing happens and
+    // the result is null.
     template <typename C>
-    C& emplace(Entity e, const C& c = C{}) { return storage<C>().emplace(e, c); }
+    C* emplace(Entity e, const C& c = C{}) {
+        assert(valid(e) && "rt::ecs::Registry::emplace on a dead entity");
+        if (!valid(e)) return nullptr;
+        std::size_t id = poolId<C>();
+        signatures_[entityIndex(e)] |= Signature{1} << id;
+        return pool<C>(id).emplace(e, c);
+    }
 
     template <typename C, typename... Args>
-    C& emplace(Entity e, Args&&... args) { return storage<C>().emplace(e, C{std::forward<Args>(args)...}); }
+    C* emplace(Entity e, Args&&... args) {
+        // Bind as const C& so this resolves to the overload above instead of recursing
+        const C& c = C{std::forward<Args>(args)...};
+        return emplace<C>(e, c);
+    }
+
+    template <typename C>
+    void remove(Entity e) {
+        std::size_t id = poolId<C>();
+        if (valid(e)) signatures_[entityIndex(e)] &= ~(Signature{1} << id);
+        pool<C>(id).remove(e);
+    }
 
     template <typename C>
     C* get(Entity e) { return storage<C>().get(e); }
 
+    // Multi-component query, see View.hpp. Optional filter: view<A, B>(exclude<C, D>)
+    template <typename... C, typename... Ex>
+    View<Exclude<Ex...>, C...> view(Exclude<Ex...> = {}) {
+        Signature include = ((Signature{1} << poolId<C>()) | ...);
+        Signature excluded = (Signature{0} | ... | (Signature{1} << poolId<Ex>()));
+        return View<Exclude<Ex...>, C...>({&storage<C>()...}, signatures_, include, excluded);
+    }
+
+    // Reorders the A pool so that its first entries follow the dense order of B,
+    // and returns n: for i < n, components()[i] of both storages belong to the
+    // same entity, ready for a straight loop or a SIMD kernel. n stops at the
+    // first B entity without an A (the caller handles B's tail one by one).
+    // Only A moves, so a scheduled system calling it writes A and may just read B.
+    // Close to free once the order is stable.
+    template <typename A, typename B>
+    std::size_t align() {
+        auto& a = storage<A>();
+        const auto& ents = storage<B>().entities();
+        std::size_t n = 0;
+        for (; n < ents.size(); ++n) {
+            std::size_t i = a.indexOf(ents[n]);
+            if (i == a.size()) break;
+            a.swapSlots(i, n);
+        }
+        return n;
+    }
+
     template <typename C>
     auto& all() { return storage<C>().data(); }
     template <typename C>
@@ -75,21 +177,107 @@ class Registry {
     template <typename C>
     auto& getall() { return storage<C>().data(); }
 
-    void addSystem(std::unique_ptr<System> sys) { systems_.push_back(std::move(sys)); }
+    // Deferred structural changes, played back after each system in update().
+    // Record spawns/despawns here instead of touching storages that are being iterated.
+    // Inside a scheduled system this is the buffer of that system.
+    CommandBuffer& commands() { return threadCommands_ ? *threadCommands_ : commands_; }
+    void flush() { commands_.flush(*this); }
+
+    void addSystem(std::unique_ptr<System> sys) {
+        systems_.push_back(std::move(sys));
+        scheduleDirty_ = true;
+    }
+
+    // 0 (the default) runs systems one after another on the calling thread.
+    // Otherwise systems are grouped into stages by their declared Access (see
+    // Scheduler.hpp) and each stage is spread over the caller plus up to `workers`
+    // threads, no more than the widest stage can keep busy.
+    void setWorkerThreads(unsigned workers) {
+        scheduler_ = workers ? std::make_unique<Scheduler>(workers) : nullptr;
+        scheduleDirty_ = true;
+    }
+
+    // Null when running sequentially; its stages are (re)built by the next update()
+    const Scheduler* scheduler() const { return scheduler_.get(); }
 
     void update(float dt) {
-        for (auto& s : systems_) s->update(*this, dt);
+        if (scheduler_) {
+            if (scheduleDirty_) scheduler_->build(*this, systems_);
+            scheduleDirty_ = false;
+            scheduler_->run(*this, systems_, dt);
+            return;
+        }
+        for (auto& s : systems_) {
+            s->update(*this, dt);
+            commands_.flush(*this);
+        }
     }
 
+    // Unordered: destroy() swaps the last live entity into the freed position
     const std::vector<Entity>& alive() const { return alive_; }
 
   private:
-    Entity last_ = 0;
+    // Family id of C, making sure its pool exists
+    template <typename C>
+    std::size_t poolId() {
+        std::size_t id = componentFamily<C>();
+        if (id < pools_.size() && pools_[id]) return id;
+        if (id >= kMaxComponentTypes)
+            throw std::length_error("rt::ecs::Registry: too many component types");
+        if (id >= pools_.size()) pools_.resize(id + 1);
+        pools_[id] = std::make_unique<ComponentStorage<C>>();
+        return id;
+    }
+
+    template <typename C>
+    ComponentStorage<C>& pool(std::size_t id) { return *static_cast<ComponentStorage<C>*>(pools_[id].get()); }
+
+    // Frees the slot only; the caller removes components using the old signature
+    void release(Entity e) {
+        Entity idx = entityIndex(e);
+        signatures_[idx] = 0;
+        // Swap-and-pop out of the alive list
+        std::uint32_t pos = alivePos_[idx];
+        Entity moved = alive_.back();
+        alive_[pos] = moved;
+        alivePos_[entityIndex(moved)] = pos;
+        alive_.pop_back();
+        // Bump the version so outstanding handles go stale, and queue the slot at
+        // the tail of the free list (a dead slot stores the next free index)
+        Entity version = entityVersion(e) + 1;
+        if (version == kPlaceholderVersion) version = 0;
+        slots_[idx] = makeEntity(0, version);
+        if (freeTail_ != 0) slots_[freeTail_] = makeEntity(idx, entityVersion(slots_[freeTail_]));
+        else freeHead_ = idx;
+        freeTail_ = idx;
+        ++freeCount_;
+    }
+
+    // Per-index tables. slots_[i] is the live handle for index i, or (next free
+    // index, next version) once destroyed. Index 0 is a reserved sentinel, also
+    // used as end of the free list.
+    std::vector<Entity> slots_{kInvalidEntity};
+    std::vector<Signature> signatures_{0};
+    std::vector<std::uint32_t> alivePos_{0};
+    // Free list, a FIFO: create() pops the head, release() appends at the tail
+    Entity freeHead_ = 0;
+    Entity freeTail_ = 0;
+    std::size_t freeCount_ = 0;
     std::vector<Entity> alive_;
-    std::unordered_map<std::type_index, std::unique_ptr<IStorage>> stores_;
+    std::vector<Entity> batch_;
+    // Indexed by componentFamily<C>(); null for types this registry never used
+    std::vector<std::unique_ptr<IStorage>> pools_;
     std::vector<std::unique_ptr<System>> systems_;
+    CommandBuffer commands_;
+    std::unique_ptr<Scheduler> scheduler_;
+    bool scheduleDirty_ = false;
+    // Set by the scheduler while a system runs on this thread
+    static inline thread_local CommandBuffer* threadCommands_ = nullptr;
 
     friend class EntityHandle;
+    friend class Scheduler;
+    template <typename C>
+    friend std::size_t componentId(Registry& r);
 };
 
 template <typename C, typename... Args>
@@ -101,4 +289,43 @@ inline EntityHandle& EntityHandle::add(Args&&... args) {
 template <typename C>
 inline C* EntityHandle::get() { return r_.get<C>(e_); }
 
+template <typename C>
+inline std::size_t componentId(Registry& r) { return r.poolId<C>(); }
+
+template <typename C>
+inline void CommandBuffer::applyEmplace(Registry& r, Entity e, const std::byte* payload) {
+    C c;
+    std::memcpy(&c, payload, sizeof(C));
+    r.emplace<C>(e, static_cast<const C&>(c));
+}
+
+template <typename C>
+inline void CommandBuffer::applyRemove(Registry& r, Entity e, const std::byte*) { r.remove<C>(e); }
+
+inline void CommandBuffer::flush(Registry& r) {
+    if (cmds_.empty()) return;
+    resolved_.assign(created_, kInvalidEntity);
+    destroyed_.clear();
+    for (const Command& c : cmds_) {
+        Entity e = isPlaceholder(c.e) ? resolved_[entityIndex(c.e)] : c.e;
+        switch (c.op) {
+            case Op::Create: resolved_[entityIndex(c.e)] = r.create(); break;
+            case Op::Emplace:
+            case Op::Remove:
+                if (c.ref != kNoRef) {
+                    std::byte* at = payload_.data() + c.offset + c.ref;
+                    Entity target;
+                    std::memcpy(&target, at, sizeof(Entity));
+                    if (isPlaceholder(target)) target = resolved_[entityIndex(target)];
+                    std::memcpy(at, &target, sizeof(Entity));
+                }
+                if (r.valid(e)) c.apply(r, e, payload_.data() + c.offset);
+                break;
+            case Op::Destroy: destroyed_.push_back(e); break;
+        }
+    }
+    clear();
+    r.destroy(destroyed_);
+}
+
 }
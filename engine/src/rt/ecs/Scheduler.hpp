@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "rt/ecs/CommandBuffer.hpp"
+#include "rt/ecs/System.hpp"
+
+namespace rt::ecs {
+
+// Runs registry systems in stages. Systems are taken in registration order and
+// each one lands in the first stage after every earlier system it conflicts
+// with (a write overlapping a read or write of the other, a shared resource, or
+// either one not declaring its Access) and after every earlier structural one.
+// Systems of one stage run concurrently on the worker threads and the calling
+// thread; their command buffers are then flushed in registration order, so
+// each system sees the same world as in a sequential run.
+class Scheduler {
+  public:
+    // At most `workers` threads; build() only starts as many as the widest stage can use
+    explicit Scheduler(unsigned workers);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Resolves accesses to component masks and groups the systems into stages.
+    // Must run on the registry's thread whenever the system list changes.
+    void build(Registry& r, const std::vector<std::unique_ptr<System>>& systems);
+    void run(Registry& r, const std::vector<std::unique_ptr<System>>& systems, float dt);
+
+    unsigned workers() const { return static_cast<unsigned>(threads_.size()); }
+    // System indices per stage, for logs and debugging
+    const std::vector<std::vector<std::size_t>>& stages() const { return stages_; }
+
+  private:
+    void startWorkers(unsigned count);
+    void stopWorkers();
+    void workerLoop();
+    // Pulls systems of the current stage until none is left
+    void drain();
+    void runOne(std::size_t system);
+
+    unsigned maxWorkers_;
+    std::vector<std::vector<std::size_t>> stages_;
+    std::vector<CommandBuffer> buffers_;
+    std::vector<bool> structural_; // per system: declared structural(), or undeclared
+
+    // Current job, valid while a stage is running
+    Registry* reg_ = nullptr;
+    const std::vector<std::unique_ptr<System>>* systems_ = nullptr;
+    const std::vector<std::size_t>* stage_ = nullptr;
+    float dt_ = 0.f;
+    std::atomic<std::size_t> next_{0};
+    std::size_t pending_ = 0;
+    std::exception_ptr error_;
+
+    std::mutex m_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::size_t generation_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}
@@ -1,7 +1,12 @@
 #pragma once
-#include <unordered_map>
-#include <typeindex>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include "rt/ecs/Types.hpp"
 
@@ -10,25 +15,155 @@ namespace rt::ecs {
 struct IStorage {
     virtual ~IStorage() = default;
     virtual void remove(Entity e) = 0;
+    // One virtual dispatch per batch; entities not in the storage are skipped
+    virtual void removeMany(std::span<const Entity> es) = 0;
 };
 
+// Sparse set: components are packed in a dense array with a parallel array of
+// owning entities. A paged sparse index maps an entity index to its dense slot,
+// pages are only allocated for index ranges that are actually used. Lookups
+// compare the full handle, so a stale (older version) entity finds nothing.
+// Removal swaps the last element into the hole, so do not remove from the
+// storage being iterated (record the destroy in Registry::commands() instead).
 template <typename C>
-class ComponentStorage : public IStorage {
+class ComponentStorage final : public IStorage {
   public:
+    static constexpr std::size_t kPageSize = 4096;
+
+    // Iterates (entity, component&) pairs in dense order. Yields by value, so
+    // bind with `auto [e, c]` (the component member is still a reference).
+    template <bool Const>
+    class Iterator {
+      public:
+        using Owner = std::conditional_t<Const, const ComponentStorage, ComponentStorage>;
+        using Ref = std::conditional_t<Const, const C&, C&>;
+        using value_type = std::pair<Entity, Ref>;
+
+        Iterator(Owner* s, std::size_t i) : s_(s), i_(i) {}
+        value_type operator*() const { return {s_->entities_[i_], s_->dense_[i_]}; }
+        Iterator& operator++() { ++i_; return *this; }
+        bool operator==(const Iterator& o) const { return i_ == o.i_; }
+        bool operator!=(const Iterator& o) const { return i_ != o.i_; }
+
+      private:
+        Owner* s_;
+        std::size_t i_;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    bool contains(Entity e) const { return slot(e) != kNone; }
+
     C* get(Entity e) {
-        auto it = data_.find(e);
-        return it == data_.end() ? nullptr : &it->second;
+        auto i = slot(e);
+        return i == kNone ? nullptr : &dense_[i];
     }
     const C* get(Entity e) const {
-        auto it = data_.find(e);
-        return it == data_.end() ? nullptr : &it->second;
+        auto i = slot(e);
+        return i == kNone ? nullptr : &dense_[i];
+    }
+
+    // Unchecked lookup: `e` must be in the storage (e.g. vouched for by its signature)
+    C& at(Entity e) {
+        std::size_t idx = entityIndex(e);
+        return dense_[(*sparse_[idx / kPageSize])[idx % kPageSize]];
     }
-    C& emplace(Entity e, const C& c = C{}) { return data_[e] = c; }
-    void remove(Entity e) override { data_.erase(e); }
-    std::unordered_map<Entity, C>& data() { return data_; }
-    const std::unordered_map<Entity, C>& data() const { return data_; }
+
+    // Inserts or overwrites. May reallocate the dense array: pointers previously
+    // returned by get() for this component type are invalidated. A slot held by
+    // another generation of the same index is left alone (null; asserted in debug
+    // builds): the registry removes a destroyed entity from every pool.
+    C* emplace(Entity e, const C& c = C{}) {
+        auto& s = sparseSlot(e);
+        if (s != kNone) {
+            assert(entities_[s] == e && "rt::ecs::ComponentStorage::emplace through a stale handle");
+            if (entities_[s] != e) return nullptr;
+            dense_[s] = c;
+            return &dense_[s];
+        }
+        s = static_cast<std::uint32_t>(dense_.size());
+        entities_.push_back(e);
+        dense_.push_back(c);
+        return &dense_.back();
+    }
+
+    void remove(Entity e) override {
+        auto i = slot(e);
+        if (i == kNone) return;
+        std::size_t last = dense_.size() - 1;
+        if (i != last) {
+            dense_[i] = std::move(dense_[last]);
+            entities_[i] = entities_[last];
+            sparseSlot(entities_[i]) = i;
+        }
+        dense_.pop_back();
+        entities_.pop_back();
+        sparseSlot(e) = kNone;
+    }
+
+    void removeMany(std::span<const Entity> es) override {
+        for (Entity e : es) remove(e);
+    }
+
+    // Dense position of `e`, or size() when it has no component here
+    std::size_t indexOf(Entity e) const {
+        auto i = slot(e);
+        return i == kNone ? dense_.size() : i;
+    }
+
+    // Exchanges two dense positions (see Registry::align). Invalidates pointers
+    // to the two components like any reordering does.
+    void swapSlots(std::size_t a, std::size_t b) {
+        if (a == b) return;
+        std::swap(dense_[a], dense_[b]);
+        std::swap(entities_[a], entities_[b]);
+        sparseSlot(entities_[a]) = static_cast<std::uint32_t>(a);
+        sparseSlot(entities_[b]) = static_cast<std::uint32_t>(b);
+    }
+
+    std::size_t size() const { return dense_.size(); }
+    bool empty() const { return dense_.empty(); }
+
+    // Contiguous views over the packed arrays (same order, same length)
+    const std::vector<Entity>& entities() const { return entities_; }
+    std::vector<C>& components() { return dense_; }
+    const std::vector<C>& components() const { return dense_; }
+
+    // Kept for call sites written against the old map-backed storage
+    ComponentStorage& data() { return *this; }
+    const ComponentStorage& data() const { return *this; }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, dense_.size()}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, dense_.size()}; }
+
   private:
-    std::unordered_map<Entity, C> data_;
+    static constexpr std::uint32_t kNone = ~std::uint32_t{0};
+    using Page = std::array<std::uint32_t, kPageSize>;
+
+    std::uint32_t slot(Entity e) const {
+        std::size_t idx = entityIndex(e);
+        std::size_t p = idx / kPageSize;
+        if (p >= sparse_.size() || !sparse_[p]) return kNone;
+        std::uint32_t i = (*sparse_[p])[idx % kPageSize];
+        return (i != kNone && entities_[i] == e) ? i : kNone;
+    }
+
+    std::uint32_t& sparseSlot(Entity e) {
+        std::size_t idx = entityIndex(e);
+        std::size_t p = idx / kPageSize;
+        if (p >= sparse_.size()) sparse_.resize(p + 1);
+        if (!sparse_[p]) {
+            sparse_[p] = std::make_unique<Page>();
+            sparse_[p]->fill(kNone);
+        }
+        return (*sparse_[p])[idx % kPageSize];
+    }
+
+    std::vector<C> dense_;
+    std::vector<Entity> entities_;
+    std::vector<std::unique_ptr<Page>> sparse_;
 };
 
 }
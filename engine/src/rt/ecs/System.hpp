@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 #include "rt/ecs/Types.hpp"
 
@@ -6,10 +7,63 @@ namespace rt::ecs {
 
 class Registry;
 
+// Pool index of C in `r`, creating the pool if needed (defined in Registry.hpp)
+template <typename C>
+std::size_t componentId(Registry& r);
+
+// What a system touches during update(). The scheduler runs systems whose
+// accesses do not conflict in the same stage, so list every component type the
+// system reads or writes, plus any non-ECS state it shares with other systems.
+// A declared system must not create/destroy entities or emplace/remove
+// components directly: it records those in Registry::commands() and declares
+// structural().
+class Access {
+  public:
+    template <typename... C>
+    Access& reads() {
+        (reads_.push_back(&componentId<C>), ...);
+        return *this;
+    }
+
+    template <typename... C>
+    Access& writes() {
+        (writes_.push_back(&componentId<C>), ...);
+        return *this;
+    }
+
+    // Shared state outside the registry (an RNG, a counter...), treated as a write
+    Access& uses(const void* resource) {
+        resources_.push_back(resource);
+        return *this;
+    }
+
+    // Records commands. They are played back at the end of the stage, and every
+    // later system must see them as it would when running sequentially, so the
+    // system ends its stage: the ones registered after it start a new one.
+    Access& structural() {
+        structural_ = true;
+        return *this;
+    }
+
+  private:
+    friend class Scheduler;
+    using IdFn = std::size_t (*)(Registry&);
+    std::vector<IdFn> reads_;
+    std::vector<IdFn> writes_;
+    std::vector<const void*> resources_;
+    bool structural_ = false;
+};
+
 class System {
   public:
     virtual ~System() = default;
     virtual void update(Registry& registry, float dt) = 0;
+    // Fill `access` and return true to let the scheduler run this system next to
+    // others. Systems that do not declare anything always run alone.
+    virtual bool declareAccess(Access& access) const {
+        (void)access;
+        return false;
+    }
 };
 
 }
@@ -1,10 +1,45 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 
 namespace rt::ecs {
+// Generational handle: low 20 bits are the slot index, high 12 bits the slot version.
+// Index 0 is never handed out, so 0 stays the invalid/"none" id on the wire too.
 using Entity = std::uint32_t;
 static constexpr Entity kInvalidEntity = 0;
 
+static constexpr unsigned kEntityIndexBits = 20;
+static constexpr Entity kEntityIndexMask = (Entity{1} << kEntityIndexBits) - 1;
+static constexpr Entity kEntityVersionMask = (Entity{1} << (32 - kEntityIndexBits)) - 1;
+
+// Version reserved for CommandBuffer placeholders; the registry never hands it out
+static constexpr Entity kPlaceholderVersion = kEntityVersionMask;
+
+constexpr Entity entityIndex(Entity e) { return e & kEntityIndexMask; }
+constexpr Entity entityVersion(Entity e) { return e >> kEntityIndexBits; }
+constexpr Entity makeEntity(Entity index, Entity version) {
+    return ((version & kEntityVersionMask) << kEntityIndexBits) | (index & kEntityIndexMask);
+}
+
+// Component mask of an entity, one bit per component type (see componentFamily)
+using Signature = std::uint64_t;
+
+namespace detail {
+inline std::size_t nextComponentFamily() {
+    static std::atomic<std::size_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+}
+
+// Process-wide dense id of a component type, handed out on first use. It is the
+// pool index and signature bit of C in every registry, so no RTTI is involved.
+template <typename C>
+std::size_t componentFamily() {
+    static const std::size_t id = detail::nextComponentFamily();
+    return id;
+}
+
 // Small, typed bits for input or flags when helpful.
 using Bits8 = std::uint8_t;
 }
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "rt/ecs/Types.hpp"
+#include "rt/ecs/Storage.hpp"
+
+namespace rt::ecs {
+
+// Filter tag for Registry::view, e.g. r.view<Transform>(exclude<BossTag>)
+template <typename... Ex>
+struct Exclude {};
+template <typename... Ex>
+inline constexpr Exclude<Ex...> exclude{};
+
+template <typename Excl, typename... C>
+class View;
+
+// Entities owning every C and none of Ex. The smallest included pool drives the
+// loop and each candidate is accepted with a single signature mask test, then
+// the components are fetched without re-checking.
+// Yields (entity, C&...) tuples: `for (auto [e, t, v] : r.view<Transform, Velocity>())`.
+// Same rules as storage iteration: defer destroys via Registry::commands(), and emplacing one of
+// the viewed component types invalidates the references handed out so far.
+template <typename... Ex, typename... C>
+class View<Exclude<Ex...>, C...> {
+    static_assert(sizeof...(C) > 0, "a view needs at least one component");
+
+  public:
+    using Pools = std::tuple<ComponentStorage<C>*...>;
+
+    View(Pools pools, const std::vector<Signature>& sigs, Signature include, Signature excluded)
+        : pools_(pools), sigs_(&sigs), include_(include), exclude_(excluded) {
+        std::size_t best = static_cast<std::size_t>(-1);
+        std::apply([&](auto*... p) {
+            ((p->size() < best ? (best = p->size(), driver_ = &p->entities(), 0) : 0), ...);
+        }, pools_);
+    }
+
+    struct Sentinel {};
+
+    class Iterator {
+      public:
+        using value_type = std::tuple<Entity, C&...>;
+
+        Iterator(const View* v, std::size_t i) : v_(v), i_(i) { skip(); }
+
+        value_type operator*() const {
+            Entity e = (*v_->driver_)[i_];
+            return value_type{e, std::get<ComponentStorage<C>*>(v_->pools_)->at(e)...};
+        }
+        Iterator& operator++() { ++i_; skip(); return *this; }
+        // Re-reads the driver size so entities appended mid-loop are visited too
+        bool operator==(Sentinel) const { return i_ >= v_->driver_->size(); }
+
+      private:
+        void skip() {
+            const auto& ents = *v_->driver_;
+            while (i_ < ents.size() && !v_->matches(ents[i_])) ++i_;
+        }
+        const View* v_;
+        std::size_t i_;
+    };
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Sentinel end() const { return {}; }
+
+    // fn(Entity, C&...)
+    template <typename Fn>
+    void each(Fn&& fn) const {
+        for (auto it = begin(); !(it == end()); ++it) std::apply(fn, *it);
+    }
+
+    // Upper bound on the number of matches (size of the driving pool)
+    std::size_t sizeHint() const { return driver_->size(); }
+
+  private:
+    bool matches(Entity e) const {
+        Signature s = (*sigs_)[entityIndex(e)];
+        return (s & include_) == include_ && (s & exclude_) == 0;
+    }
+
+    Pools pools_;
+    const std::vector<Signature>* sigs_;
+    Signature include_;
+    Signature exclude_;
+    const std::vector<Entity>* driver_ = nullptr;
+};
+
+}
@@ -43,8 +43,6 @@ struct Shooter {
     float bulletSpeed = 320.f;
 };
 
-struct BeamTag {};
-
 struct ChargeGun { float charge = 0.f; float maxCharge = 2.0f; bool firing = false; };
 
 struct EnemyShooter { float cooldown = 0.f; float interval = 1.0f; float bulletSpeed = 220.f; float accuracy = 0.6f; };
@@ -64,4 +62,13 @@ struct FormationFollower { rt::ecs::Entity formation = 0; std::uint16_t index =
 enum class PowerupType : std::uint8_t { Life = 0, Invincibility = 1, ClearBoard = 2, InfiniteFire = 3 };
 struct PowerupTag { PowerupType type = PowerupType::Life; };
 
+// Not a component: a beam shot resolved this tick, for the session to forward to clients
+struct BeamEvent {
+    rt::ecs::Entity owner = 0;
+    float x = 0.f;         // origin (left end)
+    float y = 0.f;         // vertical center
+    float length = 0.f;    // reaches the right edge of the world
+    float thickness = 0.f;
+};
+
 }
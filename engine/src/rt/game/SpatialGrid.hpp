@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "rt/ecs/Types.hpp"
+
+namespace rt::game {
+
+// Uniform grid broadphase over the world, rebuilt once per tick (BroadphaseSystem).
+// Boxes are bucketed per layer into every cell they overlap; boxes outside the
+// world are clamped into the border cells, so nothing is ever missed. Queries
+// return the entities whose cached box overlaps the query box, using the same
+// inclusive AABB test as the collision systems, in insertion order.
+class SpatialGrid {
+  public:
+    enum Layer : std::uint8_t { Enemies = 0, Players, LayerCount };
+
+    explicit SpatialGrid(float worldW = 960.f, float worldH = 600.f, float cellSize = 64.f);
+
+    // Start a new frame: drops all boxes, keeps the memory
+    void clear();
+    void insert(Layer layer, rt::ecs::Entity e, float x, float y, float w, float h);
+    // Buckets everything inserted since clear()
+    void build();
+
+    // Appends to `out` (not cleared). Boxes are a snapshot from build(): the
+    // caller re-checks liveness if entities may have been destroyed since.
+    void query(Layer layer, float x, float y, float w, float h, std::vector<rt::ecs::Entity>& out);
+
+    std::size_t size(Layer layer) const { return layers_[layer].boxes.size(); }
+
+    // Box tests done by queries since resetStats(), next to the tests a brute
+    // force scan over the same layer would have done
+    std::size_t pairTests() const { return pairTests_; }
+    std::size_t bruteForcePairTests() const { return bruteForceTests_; }
+    void resetStats() { pairTests_ = bruteForceTests_ = 0; }
+
+  private:
+    struct Box {
+        rt::ecs::Entity e;
+        float x0, y0, x1, y1;
+    };
+    struct LayerData {
+        std::vector<Box> boxes;
+        // CSR buckets: cell c holds cellItems[cellStart[c], cellStart[c + 1])
+        std::vector<std::uint32_t> cellStart;
+        std::vector<std::uint32_t> cellItems;
+        // Last query that visited a box, to report boxes spanning cells once
+        std::vector<std::uint32_t> stamp;
+    };
+
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+    float cell_;
+    int cols_;
+    int rows_;
+    LayerData layers_[LayerCount];
+    std::uint32_t queryId_ = 0;
+    std::vector<std::uint32_t> hits_;
+    std::size_t pairTests_ = 0;
+    std::size_t bruteForceTests_ = 0;
+};
+
+}
@@ -1,35 +1,50 @@
 #pragma once
 #include <random>
+#include <vector>
 #include "rt/ecs/System.hpp"
 #include "rt/ecs/Registry.hpp"
 #include "rt/game/Components.hpp"
+#include "rt/game/SpatialGrid.hpp"
 
 namespace rt::game {
 
 class InputSystem : public rt::ecs::System {
   public:
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
 };
 
 class MovementSystem : public rt::ecs::System {
   public:
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
 };
 
 class ShootingSystem : public rt::ecs::System {
   public:
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
 };
 
+// Charges while held; on release the beam hits everything in its path at once
+// (grid query, so register it after BroadphaseSystem) and emits a BeamEvent
 class ChargeShootingSystem : public rt::ecs::System {
   public:
+    ChargeShootingSystem(SpatialGrid& grid, std::vector<BeamEvent>& beams) : grid_(grid), beams_(beams) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
+  private:
+    SpatialGrid& grid_;
+    std::vector<BeamEvent>& beams_;
+    std::vector<rt::ecs::Entity> hits_;
+    std::vector<rt::ecs::Entity> killed_; // destroys recorded this tick, by any player's beam
 };
 
 class EnemyShootingSystem : public rt::ecs::System {
   public:
     explicit EnemyShootingSystem(std::mt19937& rng) : rng_(rng) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
   private:
     std::mt19937& rng_;
 };
@@ -38,6 +53,7 @@ class FormationSystem : public rt::ecs::System {
   public:
     explicit FormationSystem(float* elapsedPtr) : t_(elapsedPtr) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
   private:
     float* t_;
 };
@@ -46,6 +62,7 @@ class DespawnOffscreenSystem : public rt::ecs::System {
   public:
     explicit DespawnOffscreenSystem(float minX) : minX_(minX) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
   private:
     float minX_;
 };
@@ -55,6 +72,7 @@ class DespawnOutOfBoundsSystem : public rt::ecs::System {
     DespawnOutOfBoundsSystem(float minX, float maxX, float minY, float maxY)
         : minX_(minX), maxX_(maxX), minY_(minY), maxY_(maxY) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
   private:
     float minX_, maxX_, minY_, maxY_;
 };
@@ -62,6 +80,7 @@ class DespawnOutOfBoundsSystem : public rt::ecs::System {
 class InvincibilitySystem : public rt::ecs::System {
   public:
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
 };
 
 class FormationSpawnSystem : public rt::ecs::System {
@@ -81,6 +100,7 @@ class FormationSpawnSystem : public rt::ecs::System {
   }
   void setShooterPercent(std::uint8_t percent) { shooterPercent_ = percent; }
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
   private:
     std::mt19937& rng_;
     float timer_ = 0.f;
@@ -92,7 +112,7 @@ class FormationSpawnSystem : public rt::ecs::System {
     float baseInterval_ = 3.0f;
     float countMultiplier_ = 1.0f;
     std::uint8_t shooterPercent_ = 20; // 0..100 - percentage of enemies that shoot
-    // Internal helpers to create formations
+    // Internal helpers recording a formation in r.commands(); return the origin placeholder
     rt::ecs::Entity spawnSnake(rt::ecs::Registry& r, float y, int count);
     rt::ecs::Entity spawnLine(rt::ecs::Registry& r, float y, int count);
     rt::ecs::Entity spawnGrid(rt::ecs::Registry& r, float y, int rows, int cols);
@@ -105,6 +125,7 @@ class PowerupSpawnSystem : public rt::ecs::System {
     PowerupSpawnSystem(std::mt19937& rng, std::int32_t* teamScorePtr)
       : rng_(rng), teamScore_(teamScorePtr) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
   private:
     std::mt19937& rng_;
     std::int32_t* teamScore_;
@@ -116,17 +137,40 @@ class PowerupSpawnSystem : public rt::ecs::System {
 
 class PowerupCollisionSystem : public rt::ecs::System {
   public:
+    explicit PowerupCollisionSystem(SpatialGrid& grid) : grid_(grid) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
+  private:
+    SpatialGrid& grid_;
+    std::vector<rt::ecs::Entity> hits_;
 };
 
 class InfiniteFireSystem : public rt::ecs::System {
   public:
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
 };
 
+// Fills the grid with enemy and player boxes once per tick, after movement and despawns
+class BroadphaseSystem : public rt::ecs::System {
+  public:
+    explicit BroadphaseSystem(SpatialGrid& grid) : grid_(grid) {}
+    void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
+  private:
+    SpatialGrid& grid_;
+};
+
+// Narrow phase against the candidates of the grid built by BroadphaseSystem
 class CollisionSystem : public rt::ecs::System {
   public:
+    explicit CollisionSystem(SpatialGrid& grid) : grid_(grid) {}
     void update(rt::ecs::Registry& r, float dt) override;
+    bool declareAccess(rt::ecs::Access& a) const override;
+  private:
+    SpatialGrid& grid_;
+    std::vector<rt::ecs::Entity> hits_;
+    std::vector<rt::ecs::Entity> struck_; // players given an Invincible this frame
 };
 
 // Spawns the boss every time any player's score crosses a multiple of `threshold_`; prevents other spawns while active
@@ -148,4 +192,13 @@ class BossSystem : public rt::ecs::System {
     void update(rt::ecs::Registry& r, float dt) override;
 };
 
+// Registers the server's match systems. The order keeps the tick's game logic
+// and groups systems that do not conflict, so with worker threads they form
+// these stages (* records commands and ends its stage):
+//   Input | Invincibility | InfiniteFire,  Shooting*,  Formation | FormationSpawn*,
+//   Movement | PowerupSpawn*,  EnemyShooting*,  DespawnOffscreen*,
+//   Broadphase | DespawnOutOfBounds*,  ChargeShooting*,  Collision*,  PowerupCollision*
+void addMatchSystems(rt::ecs::Registry& r, SpatialGrid& grid, std::vector<BeamEvent>& beams, std::mt19937& rng,
+                     float* elapsed, std::int32_t* teamScore);
+
 }
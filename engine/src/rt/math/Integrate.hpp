@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+namespace rt::math {
+
+// pos[i] += vel[i] * dt for i in [0, count). Works on flat float streams, so a
+// run of {x, y} transforms and the matching run of {vx, vy} velocities can be
+// integrated in one call with count = 2 * entities. Uses AVX2 or SSE2 when the
+// engine is built for them, scalar code otherwise.
+void integrate(float* pos, const float* vel, std::size_t count, float dt);
+
+// Instruction set the kernel was compiled with ("avx2", "sse2" or "scalar")
+const char* integrateBackend();
+
+}
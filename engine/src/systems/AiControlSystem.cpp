@@ -13,7 +13,7 @@ void AiControlSystem::update(rt::ecs::Registry& r, float dt) {
     constexpr std::uint8_t kRight = 1 << 3;
 
     auto& ctrls = r.storage<rt::components::AiController>().data();
-    for (auto& [e, c] : ctrls) {
+    for (auto [e, c] : ctrls) {
         float vx = 0.f, vy = 0.f;
         if (c.bits & kLeft)  vx -= c.speed;
         if (c.bits & kRight) vx += c.speed;
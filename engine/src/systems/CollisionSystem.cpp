@@ -17,13 +17,13 @@ void CollisionSystem::update(rt::ecs::Registry& r, float dt) {
     (void)dt;
     // Build lists of players and enemies that have Position+Size
     std::vector<rt::ecs::Entity> players;
-    for (auto& [e, _] : r.storage<rt::components::Player>().data()) {
+    for (auto [e, _] : r.storage<rt::components::Player>().data()) {
         auto* p = r.get<rt::components::Position>(e);
         auto* s = r.get<rt::components::Size>(e);
         if (p && s) players.push_back(e);
     }
     if (players.empty()) return;
-    for (auto& [en, _] : r.storage<rt::components::Enemy>().data()) {
+    for (auto [en, _] : r.storage<rt::components::Enemy>().data()) {
         auto* ep = r.get<rt::components::Position>(en);
         auto* es = r.get<rt::components::Size>(en);
         if (!ep || !es) continue;
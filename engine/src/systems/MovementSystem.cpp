@@ -1,16 +1,28 @@
+#include <cstddef>
+#include <type_traits>
 #include "rt/systems/MovementSystem.hpp"
 #include "rt/ecs/Registry.hpp"
 #include "rt/components/Position.hpp"
 #include "rt/components/Velocity.hpp"
+#include "rt/math/Integrate.hpp"
 
 using namespace rt::systems;
 
 void MovementSystem::update(rt::ecs::Registry& r, float dt) {
-    auto& velocities = r.storage<rt::components::Velocity>().data();
-    for (auto& [e, v] : velocities) {
-        auto* p = r.get<rt::components::Position>(e);
-        if (!p) continue;
-        p->x += v.vx * dt;
-        p->y += v.vy * dt;
+    using rt::components::Position;
+    using rt::components::Velocity;
+    static_assert(std::is_standard_layout_v<Position> && offsetof(Position, y) == sizeof(float) &&
+                  sizeof(Position) == 2 * sizeof(float));
+    static_assert(std::is_standard_layout_v<Velocity> && offsetof(Velocity, vy) == sizeof(float) &&
+                  sizeof(Velocity) == 2 * sizeof(float));
+    std::size_t n = r.align<Position, Velocity>();
+    auto& ps = r.storage<Position>();
+    auto& vs = r.storage<Velocity>();
+    if (n > 0) rt::math::integrate(&ps.components()[0].x, &vs.components()[0].vx, n * 2, dt);
+    for (std::size_t i = n; i < vs.size(); ++i) {
+        if (auto* p = ps.get(vs.entities()[i])) {
+            p->x += vs.components()[i].vx * dt;
+            p->y += vs.components()[i].vy * dt;
+        }
     }
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <asio.hpp>
+#include <atomic>
 #include <thread>
 #include <array>
 #include <unordered_map>
@@ -9,8 +10,15 @@
 #include <string>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include "common/Protocol.hpp"
 #include "rt/ecs/Registry.hpp"
+#include "rt/game/SpatialGrid.hpp"
+#include "rt/game/Components.hpp"
+#include "common/SpscQueue.hpp"
+#include "network/PacketPool.hpp"
+#include "network/EndpointKey.hpp"
+#include "gameplay/Replication.hpp"
 
 // Forward declaration to avoid including heavy headers in the interface
 namespace rt { namespace game { class FormationSpawnSystem; } }
@@ -21,47 +29,144 @@ class TcpServer;
 
 namespace rtype::server::gameplay {
 
+// How a session shares the machine with the other matches of the process
+struct SessionConfig {
+    std::uint32_t matchId = 0;         // for logs
+    int workerThreads = -1;            // registry scheduler workers; -1: derived from the core count
+    int cpu = -1;                      // core the game thread is pinned to (Linux); -1: not pinned
+    double tickBudgetMs = 1000.0 / 60; // work per tick above this is reported as an overrun
+    std::size_t inboxes = 1;           // threads delivering packets: the io thread, plus one per UDP shard
+};
+
 class GameSession {
 public:
-    using SendFn = std::function<void(const asio::ip::udp::endpoint&, const void*, std::size_t)>;
+    using SendFn = std::function<void(const asio::ip::udp::endpoint&, const rtype::server::network::PacketRef&)>;
+    using FlushFn = std::function<void()>;
+    using ClientRemovedFn = std::function<void(const asio::ip::udp::endpoint&)>;
 
-    GameSession(asio::io_context& io, SendFn sendFn, rtype::server::TcpServer* tcpServer);
+    // sendFn may only queue: flushFn is called once at the end of every tick
+    GameSession(asio::io_context& io, SendFn sendFn, rtype::server::TcpServer* tcpServer, FlushFn flushFn = {},
+                SessionConfig config = {});
     ~GameSession();
 
     void start();
     void stop();
-    void onUdpPacket(const asio::ip::udp::endpoint& from, const char* data, std::size_t size);
+    // Called from the network threads: they only decode and queue, the game thread applies.
+    // Each producing thread uses its own inbox; hellos come from the io thread (inbox 0).
+    void onUdpPacket(const asio::ip::udp::endpoint& from, const char* data, std::size_t size, std::size_t inbox = 0);
     void onTcpHello(const std::string& username, const std::string& ip);
 
+    // Called on the game thread when a bound client leaves or times out; set before start()
+    void setOnClientRemoved(ClientRemovedFn fn) { onClientRemoved_ = std::move(fn); }
+    // Whether a match is being played (as of the last tick); readable from any thread
+    bool inMatch() const { return inMatch_.load(std::memory_order_relaxed); }
+    // Ticks whose work exceeded the budget, since start; readable from any thread
+    std::uint64_t overBudgetTicks() const { return overBudgetTicks_.load(std::memory_order_relaxed); }
+
 private:
+    // Decoded network input, handed from the io thread to the game thread
+    struct NetCommand {
+        enum class Kind : std::uint8_t {
+            Hello,       // TCP hello: username + ip
+            Input,
+            LobbyConfig,
+            StartMatch,
+            Disconnect,
+            StateAck,
+            Other        // any other valid packet: binds the endpoint, refreshes its timeout
+        };
+        Kind kind = Kind::Other;
+        asio::ip::udp::endpoint from;
+        std::string name;
+        std::string ip;
+        std::uint32_t inputSeq = 0;   // newest sample; `inputs` holds inputCount samples, oldest first
+        std::uint8_t inputCount = 0;
+        std::array<std::uint8_t, rtype::net::MaxRedundantInputs> inputs{};
+        std::uint8_t baseLives = 0;
+        std::uint8_t difficulty = 0;
+        std::uint32_t snapshotId = 0;
+        std::uint64_t seq = 0; // arrival order across inboxes
+    };
+
+    // Everything the session keeps about one bound UDP client
+    struct ClientConn {
+        std::uint32_t playerId = 0;
+        asio::ip::udp::endpoint endpoint;
+        std::chrono::steady_clock::time_point lastSeen{};
+        std::uint8_t inputBits = 0;
+        std::uint32_t inputSeq = 0; // newest input applied, echoed in snapshots
+        // Samples received ahead of the simulation (slot = sequence % size);
+        // one is applied per tick, in sequence order, whatever the arrival order
+        std::array<std::uint32_t, 32> queuedSeq{};
+        std::array<std::uint8_t, 32> queuedBits{};
+        std::uint32_t newestSeq = 0; // newest sample received
+        ClientReplication replication;
+    };
+    using EndpointKey = rtype::server::network::EndpointKey;
+
+    void enqueue(NetCommand&& cmd, std::size_t inbox);
+    // Applies everything queued since the last tick, on the game thread
+    void drainCommands();
+    // Moves each client one input sample forward: the one for this tick
+    void applyQueuedInputs();
+    void applyHello(const std::string& username, const std::string& ip);
+    void applyUdpCommand(const NetCommand& cmd);
+
     void gameLoop();
+    // Pins the game thread and reports ticks over budget every few seconds
+    void applyAffinity();
+    void trackTickBudget(std::chrono::steady_clock::duration work);
     void checkTimeouts();
-    void removeClient(const std::string& key);
+    void removeClient(const EndpointKey& key);
     void broadcastState();
-    void broadcastDespawn(std::uint32_t entityId);
     void broadcastRoster();
     void broadcastLivesUpdate(std::uint32_t id, std::uint8_t lives);
+    void broadcastBeam(const rt::game::BeamEvent& beam);
     void broadcastLobbyStatus();
     void maybeStartGame();
     void cleanupGameWorld();
 
-    static std::string makeKey(const asio::ip::udp::endpoint& ep);
+    ClientConn& bindUdpEndpoint(const asio::ip::udp::endpoint& ep, std::uint32_t playerId);
 
-    void bindUdpEndpoint(const asio::ip::udp::endpoint& ep, std::uint32_t playerId);
+    // Header + payload in one pooled buffer
+    rtype::server::network::PacketRef makePacket(rtype::net::MsgType type, const void* payload, std::size_t size);
+    // Queues the same buffer for every bound client
+    void sendToAll(const rtype::server::network::PacketRef& packet);
 
 private:
     asio::io_context& io_;
     SendFn send_;
+    FlushFn flush_;
+    // Outgoing datagrams; only the game thread acquires and releases them
+    rtype::server::network::PacketPool pool_;
+
+    SessionConfig config_;
+    ClientRemovedFn onClientRemoved_;
 
     std::thread gameThread_;
-    bool running_ = false;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> inMatch_{false};
+    std::atomic<std::uint64_t> overBudgetTicks_{0};
+    // Budget report window
+    std::chrono::steady_clock::time_point budgetWindowStart_{};
+    std::uint64_t budgetWindowOverruns_ = 0;
+    std::chrono::steady_clock::duration budgetWindowWorst_{};
+
+    // One ring per producing network thread; only the game thread pops
+    using Inbox = rtype::common::SpscQueue<NetCommand, 4096>;
+    std::vector<std::unique_ptr<Inbox>> inboxes_;
+    // Stamped at enqueue so commands from several inboxes apply in arrival order
+    // (a hello before the datagram that binds to it, and not after a newer hello)
+    std::atomic<std::uint64_t> nextSeq_{0};
+    std::vector<NetCommand> drained_;
+    std::atomic<std::size_t> droppedCommands_{0};
 
     std::chrono::steady_clock::time_point lastStateSend_{};
+    std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now(); // snapshot timestamps
     double stateHz_ = 20.0;
+    std::size_t stateBudgetBytes_ = 4096; // bytes of snapshot records per client per send (~80 KB/s at 20 Hz)
 
-    std::unordered_map<std::string, std::uint32_t> endpointToPlayerId_; // key "ip:port"
-    std::unordered_map<std::string, asio::ip::udp::endpoint> keyToEndpoint_;
-    std::unordered_map<std::uint32_t, std::uint8_t> playerInputBits_;
+    std::unordered_map<EndpointKey, ClientConn, rtype::server::network::EndpointKeyHash> clients_;
     std::unordered_map<std::uint32_t, std::string> playerNames_;
     std::unordered_map<std::uint32_t, std::uint8_t> playerLives_;
     std::unordered_map<std::uint32_t, std::int32_t> playerScores_;
@@ -69,9 +174,12 @@ private:
     std::unordered_map<std::string, std::uint32_t> pendingByIp_;
 
     rt::ecs::Registry reg_;
+    rt::game::SpatialGrid grid_; // collision broadphase, rebuilt every tick
+    std::vector<rt::game::BeamEvent> beams_; // fired during the current tick, sent then cleared
     std::mt19937 rng_;
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastSeen_;
-    std::unordered_set<std::uint32_t> lastKnownEntityIds_; // Track entities from previous tick to detect deletions
+    std::uint32_t snapshotSeq_ = 0;
+    std::vector<rtype::net::PackedEntity> world_;  // reused by broadcastState
+    std::vector<std::vector<char>> fragments_; // reused by broadcastState
 
     rtype::server::TcpServer* tcp_ = nullptr;
     bool gameStarted_ = false;
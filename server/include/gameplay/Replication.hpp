@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "common/Protocol.hpp"
+
+namespace rtype::server::gameplay {
+
+// Delta replication state of one client: the snapshots recently sent to it and
+// the newest one it acknowledged. Each new snapshot is encoded against that
+// baseline, or against the empty world when the client has none left in the
+// history (new client, or acks lost for too long).
+//
+// Entities that differ from the baseline compete for a byte budget: each one
+// accumulates priority every snapshot it stays pending (weighted by its type
+// and its distance to the client's ship) and the highest ones are sent first.
+// Sending or catching up resets the accumulator, so far or low-value entities
+// are delayed but never starved.
+class ClientReplication {
+public:
+    static constexpr std::size_t kHistory = 32;
+
+    // The client decoded `snapshotId`; older acks are ignored
+    void acknowledge(std::uint32_t snapshotId);
+    // Where the client's ship is, for distance weighting
+    void setViewer(float x, float y);
+    void clearViewer() { hasViewer_ = false; }
+    // Newest input sequence applied for this client, echoed in the next snapshots
+    void setInputAck(std::uint32_t sequence) { inputAck_ = sequence; }
+
+    // Encodes `world` (sorted by id) as snapshot `snapshotId`, taken at
+    // `serverTimeMs` on the session clock: at most
+    // `budgetBytes` of records, split into StateDelta payloads of at most
+    // `fragmentBytes` each (up to MaxSnapshotFragments). Records left out stay
+    // pending: the client keeps the baseline values until a later snapshot.
+    // Returns the number of fragments written to the front of `fragments`.
+    std::size_t encode(std::uint32_t snapshotId, std::uint32_t serverTimeMs, const std::vector<rtype::net::PackedEntity>& world,
+                       std::vector<std::vector<char>>& fragments, std::size_t fragmentBytes, std::size_t budgetBytes);
+
+private:
+    struct Snapshot {
+        std::uint32_t id = 0;
+        std::vector<rtype::net::PackedEntity> entities; // what the client holds after decoding, by id
+    };
+    // One id of the merged world/baseline walk
+    struct Item {
+        const rtype::net::PackedEntity* cur;  // null: gone since the baseline
+        const rtype::net::PackedEntity* base; // null: spawned since the baseline
+        std::uint8_t fields;                  // 0: up to date, nothing to send
+        bool send;
+        float priority;
+    };
+
+    float weight(const rtype::net::PackedEntity& e) const;
+
+    std::array<Snapshot, kHistory> history_{};
+    std::uint32_t acked_ = 0;
+    std::uint32_t inputAck_ = 0;
+    bool hasViewer_ = false;
+    float viewerX_ = 0.f;
+    float viewerY_ = 0.f;
+    // Priority of pending entities, sorted by id; rebuilt each snapshot so stale ids drop out
+    std::vector<std::pair<std::uint32_t, float>> accum_;
+    std::vector<std::pair<std::uint32_t, float>> accumNext_;
+    std::vector<Item> items_;
+    std::vector<std::size_t> order_;
+};
+
+}
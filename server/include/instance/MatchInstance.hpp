@@ -2,22 +2,32 @@
 #include <memory>
 #include <asio.hpp>
 #include "gameplay/GameSession.hpp"
+#include "protocol/UdpSendBatch.hpp"
+
+namespace rtype::server { class UdpServer; }
 
 namespace rtype::server::instance {
 
+// One match: a game session with its own game thread and its own outgoing
+// batch on the shared UDP socket, so matches never contend when sending.
 class MatchInstance {
 public:
-    MatchInstance(asio::io_context& io, std::unique_ptr<rtype::server::gameplay::GameSession> session)
-        : io_(io), session_(std::move(session)) {}
+    MatchInstance(asio::io_context& io, rtype::server::UdpServer& udp, rtype::server::TcpServer* tcp,
+                  rtype::server::gameplay::SessionConfig config);
+    ~MatchInstance() { stop(); }
 
     void start() { if (session_) session_->start(); }
     void stop()  { if (session_) session_->stop(); }
 
+    std::uint32_t id() const { return id_; }
     rtype::server::gameplay::GameSession& session() { return *session_; }
 
 private:
     asio::io_context& io_;
+    std::uint32_t id_;
     std::unique_ptr<rtype::server::gameplay::GameSession> session_;
+    // Destroyed before the session's packet pool; the game thread is stopped and flushed by then
+    rtype::server::UdpSendBatch out_;
 };
 
 }
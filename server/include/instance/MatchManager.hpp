@@ -0,0 +1,71 @@
+#pragma once
+#include <asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "instance/MatchInstance.hpp"
+#include "network/EndpointKey.hpp"
+
+namespace rtype::server { class UdpServer; class TcpServer; }
+
+namespace rtype::server::instance {
+
+// Hosts up to `maxMatches` independent matches in one process. Each match runs
+// its own game thread; with several matches allowed, each thread is pinned to
+// a core (core 0 is left to the io thread) and runs its systems inline, so the
+// process scales with matches rather than within one.
+//
+// Hellos (io thread) go to an open lobby: a partly filled one first, then an
+// idle one, then a new match. UDP datagrams (io thread or UDP shard threads)
+// go to the match their endpoint is bound to. An endpoint binds with its
+// first datagram, to the match that took the latest hello from its IP
+// (sessions also pair endpoints with hellos by IP). Established routes are
+// looked up under a shared lock, so shards do not serialise on each other.
+class MatchManager {
+public:
+    static constexpr std::size_t kPlayersPerMatch = 4;
+
+    // `inboxes`: threads delivering packets, see SessionConfig::inboxes
+    MatchManager(asio::io_context& io, rtype::server::UdpServer& udp, rtype::server::TcpServer* tcp,
+                 std::size_t maxMatches, std::size_t inboxes = 1);
+    ~MatchManager();
+
+    void start();
+    void stop();
+
+    void onTcpHello(const std::string& username, const std::string& ip);
+    // `inbox` identifies the calling thread: 0 for the io thread, 1 + k for UDP shard k
+    void onUdpPacket(const asio::ip::udp::endpoint& from, const char* data, std::size_t size, std::size_t inbox = 0);
+
+    std::size_t matchCount() const;
+
+private:
+    struct Slot {
+        std::unique_ptr<MatchInstance> match;
+        std::size_t seats = 0; // hellos routed here minus clients removed
+    };
+
+    // Both with mutex_ held exclusively
+    std::size_t pickMatch();
+    std::size_t createMatch();
+    // Posted to the io thread by a match's game thread
+    void releaseSeat(std::size_t match, const asio::ip::udp::endpoint& ep);
+
+    asio::io_context& io_;
+    rtype::server::UdpServer& udp_;
+    rtype::server::TcpServer* tcp_;
+    std::size_t maxMatches_;
+    std::size_t inboxes_;
+    std::atomic<bool> stopped_{false};
+
+    mutable std::shared_mutex mutex_;
+    std::vector<Slot> matches_;
+    std::unordered_map<network::EndpointKey, std::size_t, network::EndpointKeyHash> routes_;
+    std::unordered_map<std::string, std::size_t> pendingByIp_; // latest hello per IP, not bound yet
+};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <asio.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace rtype::server::network {
+
+// Compact UDP endpoint identity for hash maps: the address as 16 bytes (IPv4
+// in its IPv6-mapped form) and the port. Built without allocating, compared
+// and hashed as plain bytes.
+struct EndpointKey {
+    std::array<std::uint8_t, 16> addr{};
+    std::uint16_t port = 0;
+
+    static EndpointKey from(const asio::ip::udp::endpoint& ep) {
+        EndpointKey k;
+        const auto a = ep.address();
+        if (a.is_v4()) {
+            const auto b = a.to_v4().to_bytes();
+            k.addr[10] = 0xff;
+            k.addr[11] = 0xff;
+            std::memcpy(k.addr.data() + 12, b.data(), 4);
+        } else {
+            const auto b = a.to_v6().to_bytes();
+            std::memcpy(k.addr.data(), b.data(), 16);
+        }
+        k.port = ep.port();
+        return k;
+    }
+
+    bool operator==(const EndpointKey& o) const { return port == o.port && addr == o.addr; }
+};
+
+struct EndpointKeyHash {
+    std::size_t operator()(const EndpointKey& k) const noexcept {
+        std::uint64_t hi, lo;
+        std::memcpy(&hi, k.addr.data(), 8);
+        std::memcpy(&lo, k.addr.data() + 8, 8);
+        // The port lands on bytes 8-9, zero for IPv4; then the splitmix64 finaliser
+        std::uint64_t h = hi * 0x9E3779B97F4A7C15ull ^ lo ^ k.port;
+        h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 27; h *= 0x94D049BB133111EBull;
+        h ^= h >> 31;
+        return static_cast<std::size_t>(h);
+    }
+};
+
+}
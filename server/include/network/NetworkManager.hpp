@@ -1,27 +1,41 @@
 #pragma once
 #include <asio.hpp>
 #include <memory>
+#include <thread>
+#include <vector>
 #include "protocol/TcpServer.hpp"
 #include "protocol/UdpServer.hpp"
-#include "gameplay/GameSession.hpp"
+#include "instance/MatchManager.hpp"
 
 namespace rtype::server::network {
 
 class NetworkManager {
 public:
-    explicit NetworkManager(asio::io_context& io, unsigned short udpPort, unsigned short tcpPort);
+    // Up to `maxMatches` concurrent matches share the two ports. With
+    // `udpShards` > 1, UDP is received on that many SO_REUSEPORT sockets, each
+    // on its own io_context thread; otherwise on `io` like TCP.
+    NetworkManager(asio::io_context& io, unsigned short udpPort, unsigned short tcpPort, std::size_t maxMatches = 1,
+                   std::size_t udpShards = 1);
+    ~NetworkManager();
 
     void start();
     void stop();
 
     rtype::server::TcpServer& tcp() { return *tcp_; }
-    rtype::server::UdpServer& udp() { return *udp_; }
+    // The first UDP socket; batched sends go out through it
+    rtype::server::UdpServer& udp() { return *udp_.front(); }
 
 private:
+    struct Shard {
+        std::unique_ptr<asio::io_context> io;
+        std::thread thread;
+    };
+
     asio::io_context& io_;
     std::shared_ptr<rtype::server::TcpServer> tcp_;
-    std::unique_ptr<rtype::server::UdpServer> udp_;
-    std::unique_ptr<rtype::server::gameplay::GameSession> session_;
+    std::vector<Shard> shards_; // empty when UDP runs on io_; outlives the sockets using it
+    std::vector<std::unique_ptr<rtype::server::UdpServer>> udp_;
+    std::unique_ptr<rtype::server::instance::MatchManager> matches_;
 };
 
 }
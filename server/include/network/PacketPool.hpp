@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rtype::server::network {
+
+class PacketPool;
+
+// One outgoing datagram. Lives in a PacketPool chunk and goes back to the
+// pool's free list when the last PacketRef to it is dropped.
+struct PacketBuffer {
+    // Ethernet MTU minus IPv4 and UDP headers: never fragmented by IP
+    static constexpr std::size_t Capacity = 1472;
+
+    char data[Capacity];
+    std::size_t size = 0;
+    std::uint32_t refs = 0;
+    PacketBuffer* nextFree = nullptr;
+    PacketPool* pool = nullptr;
+};
+
+// Intrusive reference to a pooled buffer. Copies share the buffer, so one
+// serialised message can be queued for every client without copying it.
+// Not thread-safe: refs are taken and dropped on the pool owner's thread.
+class PacketRef {
+public:
+    PacketRef() = default;
+    PacketRef(const PacketRef& o) : buf_(o.buf_) { if (buf_) ++buf_->refs; }
+    PacketRef(PacketRef&& o) noexcept : buf_(std::exchange(o.buf_, nullptr)) {}
+    PacketRef& operator=(PacketRef o) noexcept { std::swap(buf_, o.buf_); return *this; }
+    ~PacketRef() { reset(); }
+
+    void reset();
+
+    char* data() { return buf_->data; }
+    const char* data() const { return buf_->data; }
+    std::size_t size() const { return buf_->size; }
+    // At most PacketBuffer::Capacity
+    void resize(std::size_t n) { buf_->size = n; }
+    explicit operator bool() const { return buf_ != nullptr; }
+
+private:
+    friend class PacketPool;
+    explicit PacketRef(PacketBuffer* buf) : buf_(buf) { ++buf_->refs; }
+
+    PacketBuffer* buf_ = nullptr;
+};
+
+// Free list of MTU-sized buffers, grown by chunks when empty. Once the pool
+// has grown to the peak number of datagrams in flight (one tick's worth, as
+// they are released when flushed), acquiring no longer touches the heap.
+// Must outlive every PacketRef it handed out.
+class PacketPool {
+public:
+    explicit PacketPool(std::size_t initialBuffers = 256);
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // Empty buffer (size 0)
+    PacketRef acquire();
+
+    // Heap allocations made by the pool since construction, the first chunk included
+    std::size_t allocations() const { return allocations_; }
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    friend class PacketRef;
+    void release(PacketBuffer* buf);
+    void grow(std::size_t count);
+
+    std::vector<std::unique_ptr<PacketBuffer[]>> chunks_;
+    PacketBuffer* free_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t allocations_ = 0;
+};
+
+inline void PacketRef::reset() {
+    if (buf_ && --buf_->refs == 0) buf_->pool->release(buf_);
+    buf_ = nullptr;
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <asio.hpp>
+#include <array>
+#include <vector>
+#include "network/PacketPool.hpp"
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#endif
+
+namespace rtype::server {
+
+// Outgoing datagrams of one sending thread over a shared UDP socket. queue()
+// holds a reference to the packet until it is sent: queueing one packet for
+// many clients shares the buffer. Nothing leaves until flush() (one sendmmsg
+// per 64 datagrams on Linux). Each game thread owns its batch, so batches
+// need no locking; both calls run on the thread owning the packets' pool.
+class UdpSendBatch {
+public:
+    explicit UdpSendBatch(asio::ip::udp::socket& socket);
+
+    UdpSendBatch(const UdpSendBatch&) = delete;
+    UdpSendBatch& operator=(const UdpSendBatch&) = delete;
+
+    void queue(const asio::ip::udp::endpoint& to, const network::PacketRef& packet);
+    void flush();
+    // Heap allocations made by the batch (growth past its reserve)
+    std::size_t allocations() const { return allocations_; }
+    // Datagrams the socket refused since construction
+    std::size_t dropped() const { return dropped_; }
+
+private:
+    static constexpr std::size_t kBatch = 64;
+
+#if defined(__linux__)
+    // A flush waits up to kMaxFullWaits times kFullWaitMs for room in a full
+    // send buffer, then drops what is left of the tick
+    static constexpr int kFullWaitMs = 2;
+    static constexpr int kMaxFullWaits = 4;
+
+    // Sends up to kBatch datagrams of queued_ from `first`; returns where to resume
+    std::size_t sendBatch(std::size_t first);
+    void drop(std::size_t count);
+
+    std::array<mmsghdr, kBatch> msgs_{};
+    std::array<iovec, kBatch> iov_{};
+    int fullWaits_ = 0;
+#endif
+
+    struct Queued {
+        asio::ip::udp::endpoint to;
+        network::PacketRef packet;
+    };
+    asio::ip::udp::socket& socket_;
+    std::vector<Queued> queued_;
+    std::size_t allocations_ = 0;
+    std::size_t dropped_ = 0;
+};
+
+}
@@ -3,6 +3,12 @@
 #include <array>
 #include <functional>
 #include <memory>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
 
 namespace rtype::server {
 
@@ -12,27 +18,44 @@ class UdpServer {
 public:
     using PacketHandler = std::function<void(const asio::ip::udp::endpoint&, const char*, std::size_t)>;
 
-    UdpServer(asio::io_context& io, unsigned short port);
+    // With `reusePort`, several servers can bind the same port (SO_REUSEPORT):
+    // the kernel spreads datagrams over them, by hash of the client's address
+    UdpServer(asio::io_context& io, unsigned short port, bool reusePort = false);
     ~UdpServer();
     void start();
     void stop();
     void setPacketHandler(PacketHandler handler) { handler_ = std::move(handler); }
-    void sendRaw(const asio::ip::udp::endpoint& to, const void* data, std::size_t size);
+    // Sends go through UdpSendBatch: game threads share the socket
+    asio::ip::udp::socket& socket() { return socket_; }
     void setTcpServer(TcpServer* tcp) { tcp_ = tcp; }
 
 private:
     void doReceive();
+#if defined(__linux__)
+    // Reads every datagram already queued on the socket, kBatch at a time
+    void drainSocket();
+#endif
 
 private:
+    static constexpr std::size_t kMaxDatagram = 2048;
+    static constexpr std::size_t kBatch = 64;
+
     asio::io_context& io_;
     asio::ip::udp::socket socket_;
-    std::array<char, 2048> buffer_{};
+    std::array<char, kMaxDatagram> buffer_{};
     asio::ip::udp::endpoint remote_;
     bool running_ = false;
 
+#if defined(__linux__)
+    // recvmmsg slots, wired once in the constructor
+    std::vector<char> recvData_;
+    std::array<sockaddr_storage, kBatch> recvAddrs_{};
+    std::array<iovec, kBatch> recvIov_{};
+    std::array<mmsghdr, kBatch> recvMsgs_{};
+#endif
+
     PacketHandler handler_{};
     TcpServer* tcp_ = nullptr; // to be removed later
 };
 
 }
-
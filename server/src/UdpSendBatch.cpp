@@ -0,0 +1,94 @@
+#include "protocol/UdpSendBatch.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+
+#if defined(__linux__)
+#include <poll.h>
+#endif
+
+using namespace rtype::server;
+
+UdpSendBatch::UdpSendBatch(asio::ip::udp::socket& socket) : socket_(socket) {
+    queued_.reserve(1024);
+    ++allocations_;
+}
+
+void UdpSendBatch::queue(const asio::ip::udp::endpoint& to, const network::PacketRef& packet) {
+    if (queued_.size() == queued_.capacity()) ++allocations_;
+    queued_.push_back({to, packet});
+}
+
+#if defined(__linux__)
+
+std::size_t UdpSendBatch::sendBatch(std::size_t first) {
+    const std::size_t count = std::min(kBatch, queued_.size() - first);
+    for (std::size_t i = 0; i < count; ++i) {
+        Queued& q = queued_[first + i];
+        iov_[i].iov_base = q.packet.data();
+        iov_[i].iov_len = q.packet.size();
+        msghdr& h = msgs_[i].msg_hdr;
+        h = msghdr{};
+        h.msg_name = q.to.data();
+        h.msg_namelen = static_cast<socklen_t>(q.to.size());
+        h.msg_iov = &iov_[i];
+        h.msg_iovlen = 1;
+    }
+    const int fd = socket_.native_handle();
+    int n = ::sendmmsg(fd, msgs_.data(), static_cast<unsigned>(count), MSG_DONTWAIT);
+    if (n >= 0) return first + static_cast<std::size_t>(n);
+    switch (errno) {
+        case EINTR:
+            return first;
+        case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+        case EWOULDBLOCK:
+#endif
+        {
+            // Send buffer full: give the kernel a moment to drain it, then retry
+            pollfd p{fd, POLLOUT, 0};
+            if (fullWaits_++ < kMaxFullWaits && ::poll(&p, 1, kFullWaitMs) > 0) return first;
+            // Still full: the rest of the tick is late anyway, drop it
+            drop(queued_.size() - first);
+            return queued_.size();
+        }
+        case ECONNREFUSED:
+        case EHOSTUNREACH:
+        case ENETUNREACH:
+        case EMSGSIZE:
+            // Only this datagram or its destination: drop it like the network would and go on
+            drop(1);
+            return first + 1;
+        default:
+            // The socket itself is unusable (closed on shutdown...): nothing else will go out
+            drop(queued_.size() - first);
+            return queued_.size();
+    }
+}
+
+void UdpSendBatch::flush() {
+    fullWaits_ = 0;
+    std::size_t next = 0;
+    while (next < queued_.size()) next = sendBatch(next);
+    queued_.clear(); // drops the references: buffers go back to their pool
+}
+
+void UdpSendBatch::drop(std::size_t count) {
+    if (dropped_ / 1000 != (dropped_ + count) / 1000 || dropped_ == 0)
+        std::cerr << "[server] UDP send failed, " << dropped_ + count << " datagrams dropped so far\n";
+    dropped_ += count;
+}
+
+#else
+
+void UdpSendBatch::flush() {
+    // Synchronous: the packet is released right away, on this thread
+    for (const Queued& q : queued_) {
+        asio::error_code ec;
+        socket_.send_to(asio::buffer(q.packet.data(), q.packet.size()), q.to, 0, ec);
+        if (ec) ++dropped_;
+    }
+    queued_.clear();
+}
+
+#endif
@@ -1,17 +1,41 @@
 #include "protocol/UdpServer.hpp"
 #include <iostream>
 #include <cstring>
+#include <cerrno>
+#include <stdexcept>
 
 using namespace rtype::server;
 
-UdpServer::UdpServer(asio::io_context& io, unsigned short port)
+UdpServer::UdpServer(asio::io_context& io, unsigned short port, bool reusePort)
     : io_(io)
-    , socket_(io_, asio::ip::udp::endpoint(asio::ip::udp::v4(), port))
+    , socket_(io_)
 {
+    socket_.open(asio::ip::udp::v4());
+    if (reusePort) {
+#if defined(SO_REUSEPORT)
+        int on = 1;
+        if (::setsockopt(socket_.native_handle(), SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0)
+            throw asio::system_error(asio::error_code(errno, asio::error::get_system_category()), "SO_REUSEPORT");
+#else
+        throw std::runtime_error("UDP shards need SO_REUSEPORT, not available on this platform");
+#endif
+    }
+    socket_.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), port));
     try {
         asio::socket_base::receive_buffer_size opt(1024 * 1024);
         socket_.set_option(opt);
     } catch (...) {}
+
+#if defined(__linux__)
+    recvData_.resize(kBatch * kMaxDatagram);
+    for (std::size_t i = 0; i < kBatch; ++i) {
+        recvIov_[i].iov_base = recvData_.data() + i * kMaxDatagram;
+        recvIov_[i].iov_len = kMaxDatagram;
+        recvMsgs_[i].msg_hdr.msg_iov = &recvIov_[i];
+        recvMsgs_[i].msg_hdr.msg_iovlen = 1;
+        recvMsgs_[i].msg_hdr.msg_name = &recvAddrs_[i];
+    }
+#endif
 }
 
 UdpServer::~UdpServer() { stop(); }
@@ -29,6 +53,44 @@ void UdpServer::stop() {
     }
 }
 
+#if defined(__linux__)
+
+void UdpServer::doReceive() {
+    // Wake on readability only, then read the whole backlog ourselves
+    socket_.async_wait(asio::ip::udp::socket::wait_read, [this](std::error_code ec) {
+        if (ec) return;
+        drainSocket();
+        if (running_) doReceive();
+    });
+}
+
+void UdpServer::drainSocket() {
+    const int fd = socket_.native_handle();
+    // A few batches per wakeup at most, so a flood cannot starve the TCP side
+    for (int round = 0; round < 4; ++round) {
+        for (auto& m : recvMsgs_) {
+            m.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+            m.msg_hdr.msg_flags = 0;
+        }
+        int n = ::recvmmsg(fd, recvMsgs_.data(), static_cast<unsigned>(kBatch), MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN: drained
+        }
+        for (int i = 0; i < n; ++i) {
+            const auto& h = recvMsgs_[i].msg_hdr;
+            // Larger than any message we accept
+            if (recvMsgs_[i].msg_len == 0 || (h.msg_flags & MSG_TRUNC)) continue;
+            std::memcpy(remote_.data(), h.msg_name, h.msg_namelen);
+            remote_.resize(h.msg_namelen);
+            if (handler_) handler_(remote_, static_cast<const char*>(recvIov_[i].iov_base), recvMsgs_[i].msg_len);
+        }
+        if (static_cast<std::size_t>(n) < kBatch) return;
+    }
+}
+
+#else
+
 void UdpServer::doReceive() {
     socket_.async_receive_from(
         asio::buffer(buffer_), remote_,
@@ -41,7 +103,4 @@ void UdpServer::doReceive() {
     );
 }
 
-void UdpServer::sendRaw(const asio::ip::udp::endpoint& to, const void* data, std::size_t size) {
-    auto buf = std::make_shared<std::vector<char>>(static_cast<const char*>(data), static_cast<const char*>(data) + size);
-    socket_.async_send_to(asio::buffer(*buf), to, [buf](std::error_code, std::size_t) {});
-}
+#endif
@@ -1,28 +1,65 @@
 #include "gameplay/GameSession.hpp"
 #include "protocol/TcpServer.hpp"
 #include <iostream>
+#include <cstddef>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 #include <chrono>
 #include <thread>
+#if defined(__linux__)
+#include <pthread.h>
+#endif
 #include "rt/game/Components.hpp"
 #include "rt/game/Systems.hpp"
 
 using namespace rtype::server::gameplay;
 using rtype::server::TcpServer;
 
-static std::string makeKeyLocal(const asio::ip::udp::endpoint& ep) {
-    return ep.address().to_string() + ":" + std::to_string(ep.port());
+GameSession::GameSession(asio::io_context& io, SendFn sendFn, TcpServer* tcpServer, FlushFn flushFn,
+                         SessionConfig config)
+    : io_(io), send_(std::move(sendFn)), flush_(std::move(flushFn)), config_(config), rng_(std::random_device{}()),
+      tcp_(tcpServer) {
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, config_.inboxes); ++i)
+        inboxes_.push_back(std::make_unique<Inbox>());
 }
 
-GameSession::GameSession(asio::io_context& io, SendFn sendFn, TcpServer* tcpServer)
-    : io_(io), send_(std::move(sendFn)), rng_(std::random_device{}()), tcp_(tcpServer) {}
-
 GameSession::~GameSession() { stop(); }
 
 void GameSession::start() {
     running_ = true;
     gameThread_ = std::thread([this]{ gameLoop(); });
+    applyAffinity();
+}
+
+void GameSession::applyAffinity() {
+#if defined(__linux__)
+    if (config_.cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(config_.cpu, &set);
+    if (pthread_setaffinity_np(gameThread_.native_handle(), sizeof(set), &set) != 0)
+        std::cerr << "[server] Match " << config_.matchId << ": could not pin to core " << config_.cpu << "\n";
+#endif
+}
+
+void GameSession::trackTickBudget(std::chrono::steady_clock::duration work) {
+    using namespace std::chrono;
+    if (work > duration<double, std::milli>(config_.tickBudgetMs)) {
+        overBudgetTicks_.fetch_add(1, std::memory_order_relaxed);
+        ++budgetWindowOverruns_;
+        budgetWindowWorst_ = std::max(budgetWindowWorst_, work);
+    }
+    const auto now = steady_clock::now();
+    if (now - budgetWindowStart_ < seconds(10)) return;
+    if (budgetWindowOverruns_ > 0) {
+        std::cout << "[server] Match " << config_.matchId << ": " << budgetWindowOverruns_
+                  << " ticks over the " << config_.tickBudgetMs << " ms budget in the last 10 s (worst "
+                  << duration<double, std::milli>(budgetWindowWorst_).count() << " ms)\n";
+    }
+    budgetWindowStart_ = now;
+    budgetWindowOverruns_ = 0;
+    budgetWindowWorst_ = {};
 }
 
 void GameSession::stop() {
@@ -30,7 +67,108 @@ void GameSession::stop() {
     if (gameThread_.joinable()) gameThread_.join();
 }
 
+void GameSession::enqueue(NetCommand&& cmd, std::size_t inbox) {
+    cmd.seq = nextSeq_.fetch_add(1, std::memory_order_relaxed);
+    // A full ring means the game thread is stalled; dropping is what the network would do
+    if (!inboxes_[inbox]->push(std::move(cmd))) {
+        if (droppedCommands_.fetch_add(1, std::memory_order_relaxed) % 1000 == 0)
+            std::cerr << "[server] Command queue full, dropping network input\n";
+    }
+}
+
 void GameSession::onTcpHello(const std::string& username, const std::string& ip) {
+    NetCommand cmd;
+    cmd.kind = NetCommand::Kind::Hello;
+    cmd.name = username;
+    cmd.ip = ip;
+    enqueue(std::move(cmd), 0);
+}
+
+void GameSession::onUdpPacket(const asio::ip::udp::endpoint& from, const char* data, std::size_t size, std::size_t inbox) {
+    if (size < sizeof(rtype::net::Header)) return;
+    rtype::net::Header header{};
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != rtype::net::ProtocolVersion) return;
+
+    const char* payload = data + sizeof(rtype::net::Header);
+    std::size_t payloadSize = size - sizeof(rtype::net::Header);
+
+    NetCommand cmd;
+    cmd.from = from;
+    switch (header.type) {
+        case rtype::net::MsgType::Input: {
+            constexpr std::size_t fixed = offsetof(rtype::net::InputPacket, bits);
+            if (payloadSize < fixed) return;
+            rtype::net::InputPacket in{};
+            std::memcpy(&in, payload, fixed);
+            if (in.count == 0 || in.count > rtype::net::MaxRedundantInputs || payloadSize < fixed + in.count) return;
+            if (in.sequence < in.count) return;
+            cmd.kind = NetCommand::Kind::Input;
+            cmd.inputSeq = in.sequence;
+            cmd.inputCount = in.count;
+            std::memcpy(cmd.inputs.data(), payload + fixed, in.count);
+            break;
+        }
+        case rtype::net::MsgType::LobbyConfig: {
+            if (payloadSize < sizeof(rtype::net::LobbyConfigPayload)) return;
+            rtype::net::LobbyConfigPayload cfg{};
+            std::memcpy(&cfg, payload, sizeof(cfg));
+            cmd.kind = NetCommand::Kind::LobbyConfig;
+            cmd.baseLives = cfg.baseLives;
+            cmd.difficulty = cfg.difficulty;
+            break;
+        }
+        case rtype::net::MsgType::StartMatch: cmd.kind = NetCommand::Kind::StartMatch; break;
+        case rtype::net::MsgType::Disconnect: cmd.kind = NetCommand::Kind::Disconnect; break;
+        case rtype::net::MsgType::StateAck: {
+            if (payloadSize < sizeof(rtype::net::StateAckPayload)) return;
+            rtype::net::StateAckPayload ack{};
+            std::memcpy(&ack, payload, sizeof(ack));
+            cmd.kind = NetCommand::Kind::StateAck;
+            cmd.snapshotId = ack.snapshotId;
+            break;
+        }
+        default: cmd.kind = NetCommand::Kind::Other; break;
+    }
+    enqueue(std::move(cmd), inbox);
+}
+
+void GameSession::applyQueuedInputs() {
+    // Further behind than this (client clock running fast, burst after a
+    // stall): skip to the newest samples so input latency stays bounded
+    constexpr std::uint32_t kMaxBacklog = 8;
+    for (auto& [_, conn] : clients_) {
+        if (conn.newestSeq <= conn.inputSeq) continue; // nothing new yet: the last bits hold
+        if (conn.newestSeq - conn.inputSeq > kMaxBacklog) conn.inputSeq = conn.newestSeq - 2;
+        const std::uint32_t seq = conn.inputSeq + 1;
+        const std::size_t slot = seq % conn.queuedSeq.size();
+        // Lost along with every redundant copy: that tick repeats the previous bits
+        if (conn.queuedSeq[slot] == seq) conn.inputBits = conn.queuedBits[slot];
+        conn.inputSeq = seq;
+        if (auto* pi = reg_.get<rt::game::PlayerInput>(conn.playerId))
+            pi->bits = conn.inputBits;
+    }
+}
+
+void GameSession::drainCommands() {
+    auto apply = [this](const NetCommand& cmd) {
+        if (cmd.kind == NetCommand::Kind::Hello) applyHello(cmd.name, cmd.ip);
+        else applyUdpCommand(cmd);
+    };
+    NetCommand cmd;
+    if (inboxes_.size() == 1) {
+        while (inboxes_.front()->pop(cmd)) apply(cmd);
+        return;
+    }
+    // Each inbox is in order; merge them back into arrival order
+    for (auto& inbox : inboxes_)
+        while (inbox->pop(cmd)) drained_.push_back(std::move(cmd));
+    std::sort(drained_.begin(), drained_.end(), [](const NetCommand& a, const NetCommand& b) { return a.seq < b.seq; });
+    for (const auto& c : drained_) apply(c);
+    drained_.clear();
+}
+
+void GameSession::applyHello(const std::string& username, const std::string& ip) {
     auto e = reg_.create(); // create player
     reg_.emplace<rt::game::Transform>(e, rt::game::Transform{50.f, 100.f + static_cast<float>(pendingByIp_.size()) * 40.f});
     reg_.emplace<rt::game::Velocity>(e, rt::game::Velocity{0.f, 0.f});
@@ -42,7 +180,6 @@ void GameSession::onTcpHello(const std::string& username, const std::string& ip)
     reg_.emplace<rt::game::Size>(e, rt::game::Size{20.f, 12.f});
     reg_.emplace<rt::game::Score>(e, rt::game::Score{0});
 
-    playerInputBits_[e] = 0;
     playerLives_[e] = 4;
     playerScores_[e] = 0;
     playerNames_[e] = username.empty() ? (std::string("Player") + std::to_string(e)) : username;
@@ -57,71 +194,70 @@ void GameSession::onTcpHello(const std::string& username, const std::string& ip)
     pendingByIp_[ip] = e;
 }
 
-void GameSession::bindUdpEndpoint(const asio::ip::udp::endpoint& ep, std::uint32_t playerId) {
-    auto key = makeKey(ep);
-    endpointToPlayerId_[key] = playerId;
-    keyToEndpoint_[key] = ep;
-    lastSeen_[key] = std::chrono::steady_clock::now();
+GameSession::ClientConn& GameSession::bindUdpEndpoint(const asio::ip::udp::endpoint& ep, std::uint32_t playerId) {
+    ClientConn& conn = clients_[EndpointKey::from(ep)];
+    conn = ClientConn{}; // first snapshot is a full one
+    conn.playerId = playerId;
+    conn.endpoint = ep;
+    conn.lastSeen = std::chrono::steady_clock::now();
     broadcastRoster();
     broadcastLobbyStatus();
     std::cout << "[server] Player UDP bound: id=" << playerId << " from " << ep.address().to_string() << ":" << ep.port() << std::endl;
+    return conn;
 }
 
-void GameSession::onUdpPacket(const asio::ip::udp::endpoint& from, const char* data, std::size_t size) {
-    auto key = makeKey(from);
+void GameSession::applyUdpCommand(const NetCommand& cmd) {
+    // One lookup for the whole command; no allocation once bound
+    auto found = clients_.find(EndpointKey::from(cmd.from));
+    ClientConn* conn = found != clients_.end() ? &found->second : nullptr;
 
     // If endpoint not bound, check for pending player from TCP
-    if (endpointToPlayerId_.find(key) == endpointToPlayerId_.end()) {
-        auto ip = from.address().to_string();
+    if (!conn) {
+        auto ip = cmd.from.address().to_string();
         auto it = pendingByIp_.find(ip);
         if (it != pendingByIp_.end()) {
             // bind endpoint to pending player
-            bindUdpEndpoint(from, it->second);
+            conn = &bindUdpEndpoint(cmd.from, it->second);
             pendingByIp_.erase(it);
         } else {
             return;
         }
     }
 
-    if (size < sizeof(rtype::net::Header)) return;
-    const auto* header = reinterpret_cast<const rtype::net::Header*>(data);
-    if (header->version != rtype::net::ProtocolVersion) return;
+    conn->lastSeen = std::chrono::steady_clock::now();
 
-    lastSeen_[key] = std::chrono::steady_clock::now();
-    const char* payload = data + sizeof(rtype::net::Header);
-    std::size_t payloadSize = size - sizeof(rtype::net::Header);
+    if (cmd.kind == NetCommand::Kind::StateAck) {
+        conn->replication.acknowledge(cmd.snapshotId);
+        return;
+    }
 
-    if (header->type == rtype::net::MsgType::Input) {
-        if (payloadSize >= sizeof(rtype::net::InputPacket)) {
-            auto* in = reinterpret_cast<const rtype::net::InputPacket*>(payload);
-            auto it = endpointToPlayerId_.find(key);
-            if (it != endpointToPlayerId_.end()) {
-                playerInputBits_[it->second] = in->bits;
-                if (auto* pi = reg_.get<rt::game::PlayerInput>(it->second))
-                    pi->bits = in->bits;
-            }
+    if (cmd.kind == NetCommand::Kind::Input) {
+        // Queue the samples not applied yet; repeats from earlier datagrams are dropped here
+        const std::uint32_t first = cmd.inputSeq - cmd.inputCount + 1;
+        for (std::uint32_t k = 0; k < cmd.inputCount; ++k) {
+            const std::uint32_t seq = first + k;
+            if (seq <= conn->inputSeq) continue;
+            const std::size_t slot = seq % conn->queuedSeq.size();
+            conn->queuedSeq[slot] = seq;
+            conn->queuedBits[slot] = cmd.inputs[k];
         }
+        conn->newestSeq = std::max(conn->newestSeq, cmd.inputSeq);
         return;
     }
 
-    if (header->type == rtype::net::MsgType::LobbyConfig) {
-        if (payloadSize >= sizeof(rtype::net::LobbyConfigPayload)) {
-            auto it = endpointToPlayerId_.find(key);
-            if (it != endpointToPlayerId_.end() && it->second == hostId_) {
-                auto* cfg = reinterpret_cast<const rtype::net::LobbyConfigPayload*>(payload);
-                lobbyBaseLives_ = std::clamp<std::uint8_t>(cfg->baseLives, 1, 6);
-                lobbyDifficulty_ = std::clamp<std::uint8_t>(cfg->difficulty, 0, 2);
-                std::cout << "[server] Host changed lobby: difficulty=" << (int)lobbyDifficulty_
-                          << " baseLives=" << (int)lobbyBaseLives_ << std::endl;
-                broadcastLobbyStatus();
-            }
+    if (cmd.kind == NetCommand::Kind::LobbyConfig) {
+        if (conn->playerId == hostId_) {
+            lobbyBaseLives_ = std::clamp<std::uint8_t>(cmd.baseLives, 1, 6);
+            lobbyDifficulty_ = std::clamp<std::uint8_t>(cmd.difficulty, 0, 2);
+            std::cout << "[server] Host changed lobby: difficulty=" << (int)lobbyDifficulty_
+                      << " baseLives=" << (int)lobbyBaseLives_ << std::endl;
+            broadcastLobbyStatus();
         }
         return;
     }
 
-    if (header->type == rtype::net::MsgType::StartMatch) {
-        auto it = endpointToPlayerId_.find(key);
-        if (it != endpointToPlayerId_.end() && it->second == hostId_ && !gameStarted_) {
+    if (cmd.kind == NetCommand::Kind::StartMatch) {
+        if (conn->playerId == hostId_ && !gameStarted_) {
             std::cout << "[server] Host started the match!" << std::endl;
             gameStarted_ = true;
 
@@ -164,7 +300,6 @@ void GameSession::onUdpPacket(const asio::ip::udp::endpoint& from, const char* d
 
             // Make sure game world is clean before starting
             cleanupGameWorld();
-            lastKnownEntityIds_.clear(); // Reset entity tracking
 
             std::cout << "[server] Game initialized for " << playerLives_.size() << " players\n";
 
@@ -172,21 +307,14 @@ void GameSession::onUdpPacket(const asio::ip::udp::endpoint& from, const char* d
             broadcastLobbyStatus();
 
             // Send initial score update
-            rtype::net::Header scoreHdr{};
-            scoreHdr.version = rtype::net::ProtocolVersion;
-            scoreHdr.type = rtype::net::MsgType::ScoreUpdate;
-            scoreHdr.size = sizeof(rtype::net::ScoreUpdatePayload);
             rtype::net::ScoreUpdatePayload scorePayload{ 0, 0 };
-            std::vector<char> scoreOut(sizeof(scoreHdr) + sizeof(scorePayload));
-            std::memcpy(scoreOut.data(), &scoreHdr, sizeof(scoreHdr));
-            std::memcpy(scoreOut.data() + sizeof(scoreHdr), &scorePayload, sizeof(scorePayload));
-            for (const auto& [_, ep] : keyToEndpoint_) send_(ep, scoreOut.data(), scoreOut.size());
+            sendToAll(makePacket(rtype::net::MsgType::ScoreUpdate, &scorePayload, sizeof(scorePayload)));
         }
         return;
     }
 
-    if (header->type == rtype::net::MsgType::Disconnect) {
-        removeClient(key);
+    if (cmd.kind == NetCommand::Kind::Disconnect) {
+        removeClient(found != clients_.end() ? found->first : EndpointKey::from(cmd.from));
         return;
     }
 }
@@ -198,32 +326,36 @@ void GameSession::gameLoop() {
     const double stateInterval = 1.0 / std::max(1.0, stateHz_);
     auto next = clock::now();
     float elapsed = 0.f;
+    std::size_t poolAllocations = pool_.allocations();
     lastStateSend_ = clock::now();
 
-    reg_.addSystem(std::make_unique<rt::game::InputSystem>());
-    reg_.addSystem(std::make_unique<rt::game::ShootingSystem>());
-    reg_.addSystem(std::make_unique<rt::game::ChargeShootingSystem>());
-    reg_.addSystem(std::make_unique<rt::game::FormationSystem>(&elapsed));
-    reg_.addSystem(std::make_unique<rt::game::MovementSystem>());
-    reg_.addSystem(std::make_unique<rt::game::EnemyShootingSystem>(rng_));
-    reg_.addSystem(std::make_unique<rt::game::DespawnOffscreenSystem>(-50.f));
-    reg_.addSystem(std::make_unique<rt::game::DespawnOutOfBoundsSystem>(-50.f, 1000.f, -50.f, 600.f));
-    reg_.addSystem(std::make_unique<rt::game::CollisionSystem>());
-    reg_.addSystem(std::make_unique<rt::game::InvincibilitySystem>());
-    reg_.addSystem(std::make_unique<rt::game::PowerupSpawnSystem>(rng_, &lastTeamScore_));
-    reg_.addSystem(std::make_unique<rt::game::PowerupCollisionSystem>());
-    reg_.addSystem(std::make_unique<rt::game::InfiniteFireSystem>());
-    reg_.addSystem(std::make_unique<rt::game::FormationSpawnSystem>(rng_, &elapsed));
+    // Independent systems of a tick run side by side; keep a core for the io threads.
+    // The widest stage of addMatchSystems has three systems, so two workers are plenty.
+    // With several matches per process the cores are shared out by the match manager.
+    unsigned hw = std::thread::hardware_concurrency();
+    reg_.setWorkerThreads(config_.workerThreads >= 0 ? static_cast<unsigned>(config_.workerThreads)
+                                                     : std::min(2u, hw > 2 ? hw - 2 : 0u));
+    budgetWindowStart_ = clock::now();
+    rt::game::addMatchSystems(reg_, grid_, beams_, rng_, &elapsed, &lastTeamScore_);
 
     while (running_) {
+        const auto tickStart = clock::now();
         next += std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt));
         elapsed += static_cast<float>(dt);
 
+        // Everything the io thread received since last tick; session state is only touched here
+        drainCommands();
+        applyQueuedInputs();
+
         // Only run game systems if the match has started
         if (gameStarted_) {
             reg_.update(static_cast<float>(dt));
 
-            for (auto& [e, inp] : reg_.storage<rt::game::PlayerInput>().data()) {
+            // Beams are resolved within the tick; clients only get a one-shot event to draw
+            for (const auto& beam : beams_) broadcastBeam(beam);
+            beams_.clear();
+
+            for (auto [e, inp] : reg_.storage<rt::game::PlayerInput>().data()) {
                 (void)inp;
                 if (auto* hf = reg_.get<rt::game::HitFlag>(e)) {
                     if (hf->value) {
@@ -269,7 +401,7 @@ void GameSession::gameLoop() {
             }
 
             std::int32_t teamScore = 0;
-            for (auto& [e, inp] : reg_.storage<rt::game::PlayerInput>().data()) {
+            for (auto [e, inp] : reg_.storage<rt::game::PlayerInput>().data()) {
                 (void)inp;
                 if (auto* sc = reg_.get<rt::game::Score>(e)) {
                     playerScores_[e] = sc->value;
@@ -278,15 +410,8 @@ void GameSession::gameLoop() {
             }
             if (teamScore != lastTeamScore_) {
                 lastTeamScore_ = teamScore;
-                rtype::net::Header hdr{};
-                hdr.version = rtype::net::ProtocolVersion;
-                hdr.type = rtype::net::MsgType::ScoreUpdate;
-                hdr.size = sizeof(rtype::net::ScoreUpdatePayload);
                 rtype::net::ScoreUpdatePayload p{ 0, teamScore };
-                std::vector<char> out(sizeof(hdr) + sizeof(p));
-                std::memcpy(out.data(), &hdr, sizeof(hdr));
-                std::memcpy(out.data() + sizeof(hdr), &p, sizeof(p));
-                for (const auto& [_, ep] : keyToEndpoint_) send_(ep, out.data(), out.size());
+                sendToAll(makePacket(rtype::net::MsgType::ScoreUpdate, &p, sizeof(p)));
             }
         }
 
@@ -294,76 +419,73 @@ void GameSession::gameLoop() {
 
         auto now = clock::now();
         if (std::chrono::duration<double>(now - lastStateSend_).count() >= stateInterval) {
-            // Detect destroyed entities by comparing before/after entity sets
-            std::unordered_set<std::uint32_t> currentEntityIds;
-            std::unordered_set<std::uint32_t> playerIds;
-            for (const auto& [_, pid] : endpointToPlayerId_) {
-                playerIds.insert(pid);
-            }
-            for (auto& [e, nt] : reg_.storage<rt::game::NetType>().data()) {
-                currentEntityIds.insert(e);
-            }
-            // Send Despawn for entities that disappeared (excluding players)
-            for (std::uint32_t id : lastKnownEntityIds_) {
-                if (currentEntityIds.find(id) == currentEntityIds.end() && playerIds.find(id) == playerIds.end()) {
-                    broadcastDespawn(id);
-                }
-            }
-            lastKnownEntityIds_ = currentEntityIds;
+            // Despawns are part of the snapshot deltas
             broadcastState();
             lastStateSend_ = now;
         }
 
+        // Everything this tick sent leaves in one batch
+        if (flush_) flush_();
+
+        inMatch_.store(gameStarted_, std::memory_order_relaxed);
+        trackTickBudget(clock::now() - tickStart);
+        // Too far behind to catch up (stall, overloaded core): drop the lost time
+        // rather than running a burst of back-to-back ticks
+        if (clock::now() - next > std::chrono::duration<double>(5 * dt))
+            next = clock::now();
+
+        // The send path should stop allocating once warmed up; say so when it does not
+        if (pool_.allocations() != poolAllocations) {
+            poolAllocations = pool_.allocations();
+            std::cout << "[server] Packet pool grew: " << pool_.capacity() << " buffers, "
+                      << poolAllocations << " allocations\n";
+        }
+
         std::this_thread::sleep_until(next);
     }
+
+    // Nothing may stay queued past the pool's lifetime
+    if (flush_) flush_();
 }
 
 void GameSession::checkTimeouts() {
     using namespace std::chrono;
     const auto now = steady_clock::now();
     const auto timeout = seconds(10);
-    std::vector<std::string> toRemove;
-    for (auto& [key, last] : lastSeen_) {
-        if (now - last > timeout)
+    std::vector<EndpointKey> toRemove;
+    for (auto& [key, conn] : clients_) {
+        if (now - conn.lastSeen > timeout)
             toRemove.push_back(key);
     }
     for (auto& key : toRemove)
         removeClient(key);
 }
 
-void GameSession::removeClient(const std::string& key) {
-    auto it = endpointToPlayerId_.find(key);
-    if (it == endpointToPlayerId_.end()) return;
-    auto id = it->second;
+void GameSession::removeClient(const EndpointKey& key) {
+    auto it = clients_.find(key);
+    if (it == clients_.end()) return;
+    const auto id = it->second.playerId;
+    const auto ep = it->second.endpoint;
 
     bool wasHost = (id == hostId_);
+    if (onClientRemoved_) onClientRemoved_(ep);
 
-    endpointToPlayerId_.erase(it);
-    keyToEndpoint_.erase(key);
-    lastSeen_.erase(key);
-    playerInputBits_.erase(id);
+    clients_.erase(it);
     playerLives_.erase(id);
     playerScores_.erase(id);
     playerNames_.erase(id);
     try { reg_.destroy(id); } catch (...) {}
 
-    rtype::net::Header hdr{};
-    hdr.size = sizeof(std::uint32_t);
-    hdr.type = rtype::net::MsgType::Despawn;
-    hdr.version = rtype::net::ProtocolVersion;
-    std::vector<char> out(sizeof(hdr) + sizeof(std::uint32_t));
-    std::memcpy(out.data(), &hdr, sizeof(hdr));
-    std::memcpy(out.data() + sizeof(hdr), &id, sizeof(id));
-    for (auto& [_, ep] : keyToEndpoint_)
-        send_(ep, out.data(), out.size());
+    sendToAll(makePacket(rtype::net::MsgType::Despawn, &id, sizeof(id)));
 
-    std::cout << "[server] Removed disconnected client: " << key << " (id=" << id << ")\n";
+    std::cout << "[server] Removed disconnected client: " << ep.address().to_string() << ":" << ep.port()
+              << " (id=" << id << ")\n";
 
     // Reassign host if needed
-    if (wasHost && !endpointToPlayerId_.empty()) {
-        hostId_ = endpointToPlayerId_.begin()->second;
+    if (wasHost && !clients_.empty()) {
+        hostId_ = clients_.begin()->second.playerId;
         std::cout << "[server] New host assigned: id=" << hostId_ << std::endl;
-    } else if (endpointToPlayerId_.empty()) {
+    } else if (clients_.empty()) {
         hostId_ = 0;
         gameStarted_ = false;
         cleanupGameWorld();
@@ -374,113 +496,57 @@ void GameSession::removeClient(const std::string& key) {
     broadcastLobbyStatus();
 
     // If game was running and not enough players remain, stop the game
-    if (endpointToPlayerId_.size() > 0 && endpointToPlayerId_.size() < 2 && gameStarted_) {
+    if (clients_.size() > 0 && clients_.size() < 2 && gameStarted_) {
         std::cout << "[server] Not enough players to continue. Stopping game.\n";
-        rtype::net::Header rtm{0, rtype::net::MsgType::ReturnToMenu, rtype::net::ProtocolVersion};
-        for (auto& [_, ep] : keyToEndpoint_) {
-            send_(ep, &rtm, sizeof(rtm));
-        }
+        sendToAll(makePacket(rtype::net::MsgType::ReturnToMenu, nullptr, 0));
         gameStarted_ = false;
         cleanupGameWorld();
         broadcastLobbyStatus();
     }
 }
 
-void GameSession::broadcastDespawn(std::uint32_t entityId) {
-    rtype::net::Header hdr{};
-    hdr.size = sizeof(std::uint32_t);
-    hdr.type = rtype::net::MsgType::Despawn;
-    hdr.version = rtype::net::ProtocolVersion;
-    std::vector<char> out(sizeof(hdr) + sizeof(std::uint32_t));
-    std::memcpy(out.data(), &hdr, sizeof(hdr));
-    std::memcpy(out.data() + sizeof(hdr), &entityId, sizeof(entityId));
-    for (const auto& [_, ep] : keyToEndpoint_)
-        send_(ep, out.data(), out.size());
-}
-
 void GameSession::broadcastState() {
-    rtype::net::Header hdr{};
-    hdr.version = rtype::net::ProtocolVersion;
-    hdr.type = rtype::net::MsgType::State;
-
-    // Slightly larger snapshot budget; still below common MTU (~1500)
-    constexpr std::size_t kMaxUdpBytes   = 1400;
-    constexpr std::size_t kHeaderBytes   = sizeof(rtype::net::Header);
-    constexpr std::size_t kStateHdrBytes = sizeof(rtype::net::StateHeader);
-    constexpr std::size_t kEntBytes      = sizeof(rtype::net::PackedEntity);
-
-    const std::size_t maxEntities = (kMaxUdpBytes > (kHeaderBytes + kStateHdrBytes))
-        ? ((kMaxUdpBytes - (kHeaderBytes + kStateHdrBytes)) / kEntBytes)
-        : 0;
-
-    std::vector<rtype::net::PackedEntity> players;
-    std::vector<rtype::net::PackedEntity> bullets;
-    std::vector<rtype::net::PackedEntity> enemies;
-    std::vector<rtype::net::PackedEntity> powerups;
-    players.reserve(16); bullets.reserve(64); enemies.reserve(64); powerups.reserve(16);
-
-    auto& types = reg_.storage<rt::game::NetType>().data();
-    for (auto& [e, nt] : types) {
-        auto* tr = reg_.get<rt::game::Transform>(e);
-        auto* ve = reg_.get<rt::game::Velocity>(e);
-        auto* co = reg_.get<rt::game::ColorRGBA>(e);
-        if (!tr || !ve || !co) continue;
-        rtype::net::PackedEntity pe{};
-        pe.id = e;
-        pe.type = nt.type;
-        pe.x = tr->x; pe.y = tr->y;
-        pe.vx = ve->vx; pe.vy = ve->vy;
-        pe.rgba = co->rgba;
-        switch (nt.type) {
-            case rtype::net::EntityType::Player: players.push_back(pe); break;
-            case rtype::net::EntityType::Bullet: bullets.push_back(pe); break;
-            case rtype::net::EntityType::Powerup: powerups.push_back(pe); break;
-            case rtype::net::EntityType::Enemy:
-            default: enemies.push_back(pe); break;
+    // Everyone gets the same world; sorted by id so each client's delta is a merge with its baseline
+    world_.clear();
+    for (auto [e, nt, tr, ve, co] : reg_.view<rt::game::NetType, rt::game::Transform, rt::game::Velocity, rt::game::ColorRGBA>()) {
+        world_.push_back(rtype::net::packEntity(e, nt.type, tr.x, tr.y, ve.vx, ve.vy, co.rgba));
+    }
+    std::sort(world_.begin(), world_.end(), [](const auto& a, const auto& b) { return a.id < b.id; });
+
+    // One datagram per fragment, each below common MTU (~1500)
+    constexpr std::size_t kMaxUdpBytes = 1400;
+    constexpr std::size_t kFragmentBytes = kMaxUdpBytes - sizeof(rtype::net::Header);
+
+    ++snapshotSeq_;
+    // Clients place the snapshot on their timeline with this, not with its arrival time
+    const auto serverTimeMs = static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch_).count());
+    for (auto& [_, conn] : clients_) {
+        auto& repl = conn.replication;
+        // Nearby entities are refreshed first when the budget is short
+        const auto* t = reg_.get<rt::game::Transform>(conn.playerId);
+        if (t) repl.setViewer(t->x, t->y);
+        else repl.clearViewer();
+        repl.setInputAck(conn.inputSeq);
+        std::size_t count = repl.encode(snapshotSeq_, serverTimeMs, world_, fragments_, kFragmentBytes, stateBudgetBytes_);
+        for (std::size_t k = 0; k < count; ++k) {
+            const auto& payload = fragments_[k];
+            send_(conn.endpoint, makePacket(rtype::net::MsgType::StateDelta, payload.data(), payload.size()));
         }
     }
-
-    // Split across two datagrams to avoid crowding out enemies when bullets spike.
-    auto sendBatch = [&](const std::vector<rtype::net::PackedEntity>& batch) {
-        rtype::net::StateHeader sh{};
-        sh.count = static_cast<std::uint16_t>(batch.size());
-        std::size_t payloadSize = sizeof(rtype::net::StateHeader) + batch.size() * sizeof(rtype::net::PackedEntity);
-        hdr.size = static_cast<std::uint16_t>(payloadSize);
-        std::vector<char> out(sizeof(rtype::net::Header) + payloadSize);
-        std::memcpy(out.data(), &hdr, sizeof(hdr));
-        std::memcpy(out.data() + sizeof(hdr), &sh, sizeof(sh));
-        auto* arr = reinterpret_cast<rtype::net::PackedEntity*>(out.data() + sizeof(hdr) + sizeof(sh));
-        for (std::uint16_t i = 0; i < sh.count; ++i) arr[i] = batch[i];
-        for (const auto& [key, ep] : keyToEndpoint_) send_(ep, out.data(), out.size());
-    };
-
-    // Packet A: players + enemies (authoritative for presence)
-    std::vector<rtype::net::PackedEntity> a;
-    a.reserve(std::min<std::size_t>(players.size() + enemies.size(), maxEntities));
-    auto appendLimitedA = [&](const std::vector<rtype::net::PackedEntity>& src) {
-        for (const auto& pe : src) { if (a.size() >= maxEntities) break; a.push_back(pe); }
-    };
-    appendLimitedA(players);
-    appendLimitedA(enemies);
-    sendBatch(a);
-
-    // Packet B: bullets + powerups (may be many; send as much as fits)
-    std::vector<rtype::net::PackedEntity> b;
-    b.reserve(std::min<std::size_t>(bullets.size() + powerups.size(), maxEntities));
-    auto appendLimitedB = [&](const std::vector<rtype::net::PackedEntity>& src) {
-        for (const auto& pe : src) { if (b.size() >= maxEntities) break; b.push_back(pe); }
-    };
-    appendLimitedB(bullets);
-    appendLimitedB(powerups);
-    if (!b.empty()) sendBatch(b);
 }
 
 void GameSession::broadcastRoster() {
+    // Entries are written straight after the roster header, in the packet itself
+    const std::size_t maxEntries = (rtype::server::network::PacketBuffer::Capacity - sizeof(rtype::net::Header)
+                                    - sizeof(rtype::net::RosterHeader)) / sizeof(rtype::net::PlayerEntry);
     rtype::net::RosterHeader rh{};
-    std::vector<rtype::net::PlayerEntry> entries;
-    entries.reserve(endpointToPlayerId_.size());
+    auto packet = makePacket(rtype::net::MsgType::Roster, &rh, sizeof(rh));
+    std::size_t count = 0;
 
-    for (const auto& [key, pid] : endpointToPlayerId_) {
+    for (const auto& [_, conn] : clients_) {
+        if (count == maxEntries) break;
+        const auto pid = conn.playerId;
         rtype::net::PlayerEntry pe{};
         pe.id = pid;
 
@@ -494,45 +560,32 @@ void GameSession::broadcastRoster() {
         std::memset(pe.name, 0, sizeof(pe.name));
         std::strncpy(pe.name, name.c_str(), sizeof(pe.name) - 1);
 
-        entries.push_back(pe);
+        std::memcpy(packet.data() + packet.size(), &pe, sizeof(pe));
+        packet.resize(packet.size() + sizeof(pe));
+        ++count;
     }
 
-    rh.count = static_cast<std::uint8_t>(entries.size());
-
+    rh.count = static_cast<std::uint8_t>(count);
     rtype::net::Header hdr{};
     hdr.version = rtype::net::ProtocolVersion;
     hdr.type = rtype::net::MsgType::Roster;
-    hdr.size = static_cast<std::uint16_t>(sizeof(rh) + entries.size() * sizeof(rtype::net::PlayerEntry));
-
-    std::vector<char> out(sizeof(hdr) + hdr.size);
-    std::memcpy(out.data(), &hdr, sizeof(hdr));
-    std::memcpy(out.data() + sizeof(hdr), &rh, sizeof(rh));
-    if (!entries.empty())
-        std::memcpy(out.data() + sizeof(hdr) + sizeof(rh), entries.data(), entries.size() * sizeof(rtype::net::PlayerEntry));
-
-    for (const auto& [_, ep] : keyToEndpoint_)
-        send_(ep, out.data(), out.size());
+    hdr.size = static_cast<std::uint16_t>(packet.size() - sizeof(hdr));
+    std::memcpy(packet.data(), &hdr, sizeof(hdr));
+    std::memcpy(packet.data() + sizeof(hdr), &rh, sizeof(rh));
+    sendToAll(packet);
 }
 
 void GameSession::broadcastLivesUpdate(std::uint32_t id, std::uint8_t lives) {
-    rtype::net::Header hdr{};
-    hdr.version = rtype::net::ProtocolVersion;
-    hdr.type = rtype::net::MsgType::LivesUpdate;
-    hdr.size = sizeof(rtype::net::LivesUpdatePayload);
     rtype::net::LivesUpdatePayload p{ id, lives };
-    std::vector<char> out(sizeof(hdr) + sizeof(p));
-    std::memcpy(out.data(), &hdr, sizeof(hdr));
-    std::memcpy(out.data() + sizeof(hdr), &p, sizeof(p));
-    for (const auto& [_, ep] : keyToEndpoint_)
-        send_(ep, out.data(), out.size());
+    sendToAll(makePacket(rtype::net::MsgType::LivesUpdate, &p, sizeof(p)));
 }
 
-void GameSession::broadcastLobbyStatus() {
-    rtype::net::Header hdr{};
-    hdr.version = rtype::net::ProtocolVersion;
-    hdr.type = rtype::net::MsgType::LobbyStatus;
-    hdr.size = sizeof(rtype::net::LobbyStatusPayload);
+void GameSession::broadcastBeam(const rt::game::BeamEvent& beam) {
+    rtype::net::BeamPayload p{ beam.owner, beam.x, beam.y, beam.length, beam.thickness };
+    sendToAll(makePacket(rtype::net::MsgType::Beam, &p, sizeof(p)));
+}
 
+void GameSession::broadcastLobbyStatus() {
     rtype::net::LobbyStatusPayload payload{};
     payload.hostId = hostId_;
     payload.baseLives = lobbyBaseLives_;
@@ -540,12 +593,7 @@ void GameSession::broadcastLobbyStatus() {
     payload.started = gameStarted_ ? 1 : 0;
     payload.reserved = 0;
 
-    std::vector<char> out(sizeof(hdr) + sizeof(payload));
-    std::memcpy(out.data(), &hdr, sizeof(hdr));
-    std::memcpy(out.data() + sizeof(hdr), &payload, sizeof(payload));
-
-    for (const auto& [_, ep] : keyToEndpoint_)
-        send_(ep, out.data(), out.size());
+    sendToAll(makePacket(rtype::net::MsgType::LobbyStatus, &payload, sizeof(payload)));
 }
 
 void GameSession::maybeStartGame() {
@@ -558,24 +606,20 @@ void GameSession::cleanupGameWorld() {
     std::vector<rt::ecs::Entity> toDestroy;
 
     // Find all entities that are not players
-    for (auto& [e, nt] : reg_.storage<rt::game::NetType>().data()) {
+    for (auto [e, nt] : reg_.storage<rt::game::NetType>().data()) {
         if (nt.type != rtype::net::EntityType::Player) {
             toDestroy.push_back(e);
         }
     }
 
     // Also destroy formations (they may not have NetType component)
-    for (auto& [e, f] : reg_.storage<rt::game::Formation>().data()) {
+    for (auto [e, f] : reg_.storage<rt::game::Formation>().data()) {
         (void)f;
         toDestroy.push_back(e);
     }
 
-    // Destroy all collected entities
-    for (auto e : toDestroy) {
-        try {
-            reg_.destroy(e);
-        } catch (...) {}
-    }
+    // Destroy all collected entities in one batch
+    reg_.destroy(toDestroy);
 
     // Reset team score
     lastTeamScore_ = 0;
@@ -583,6 +627,19 @@ void GameSession::cleanupGameWorld() {
     std::cout << "[server] Game world cleaned: " << toDestroy.size() << " entities removed\n";
 }
 
-std::string GameSession::makeKey(const asio::ip::udp::endpoint& ep) {
-    return makeKeyLocal(ep);
+rtype::server::network::PacketRef GameSession::makePacket(rtype::net::MsgType type, const void* payload, std::size_t size) {
+    rtype::net::Header hdr{};
+    hdr.version = rtype::net::ProtocolVersion;
+    hdr.type = type;
+    hdr.size = static_cast<std::uint16_t>(size);
+    auto packet = pool_.acquire();
+    std::memcpy(packet.data(), &hdr, sizeof(hdr));
+    if (size > 0) std::memcpy(packet.data() + sizeof(hdr), payload, size);
+    packet.resize(sizeof(hdr) + size);
+    return packet;
+}
+
+void GameSession::sendToAll(const rtype::server::network::PacketRef& packet) {
+    for (const auto& [_, conn] : clients_)
+        send_(conn.endpoint, packet);
 }
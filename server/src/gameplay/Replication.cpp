@@ -0,0 +1,150 @@
+#include "gameplay/Replication.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace rtype::server::gameplay;
+using rtype::net::PackedEntity;
+
+void ClientReplication::acknowledge(std::uint32_t snapshotId) {
+    if (snapshotId > acked_) acked_ = snapshotId;
+}
+
+void ClientReplication::setViewer(float x, float y) {
+    hasViewer_ = true;
+    viewerX_ = x;
+    viewerY_ = y;
+}
+
+float ClientReplication::weight(const PackedEntity& e) const {
+    float w = 1.f;
+    switch (e.type) {
+        case rtype::net::EntityType::Player: w = 4.f; break;
+        case rtype::net::EntityType::Enemy: w = 2.f; break;
+        case rtype::net::EntityType::Bullet: w = 1.5f; break;
+        case rtype::net::EntityType::Powerup: w = 1.f; break;
+    }
+    if (!hasViewer_) return w;
+    // Up to 4x right on the ship, 2x at 200 px, tending to 1x far away
+    const float dx = rtype::net::dequantizePosition(e.x) - viewerX_;
+    const float dy = rtype::net::dequantizePosition(e.y) - viewerY_;
+    const float d = std::sqrt(dx * dx + dy * dy);
+    return w * (1.f + 600.f / (200.f + d));
+}
+
+std::size_t ClientReplication::encode(std::uint32_t snapshotId, std::uint32_t serverTimeMs,
+                                      const std::vector<PackedEntity>& world,
+                                      std::vector<std::vector<char>>& fragments, std::size_t fragmentBytes,
+                                      std::size_t budgetBytes) {
+    static const std::vector<PackedEntity> kEmpty;
+    // The client keeps its last kHistory decoded snapshots in the same slots
+    const Snapshot& ackedSlot = history_[acked_ % kHistory];
+    const bool hasBaseline = acked_ != 0 && ackedSlot.id == acked_ && snapshotId - acked_ < kHistory;
+    const std::vector<PackedEntity>& base = hasBaseline ? ackedSlot.entities : kEmpty;
+
+    // Walk world and baseline together (both sorted by id), accumulating priority of pending entities
+    items_.clear();
+    accumNext_.clear();
+    std::size_t pendingBytes = 0;
+    std::size_t a = 0; // ids only grow along the walk, so accum_ is read with a cursor
+    auto pending = [&](const PackedEntity* cur, const PackedEntity* old, std::uint8_t fields) {
+        const PackedEntity& e = cur ? *cur : *old;
+        while (a < accum_.size() && accum_[a].first < e.id) ++a;
+        const float p = (a < accum_.size() && accum_[a].first == e.id ? accum_[a].second : 0.f) + weight(e);
+        items_.push_back({cur, old, fields, true, p});
+        pendingBytes += rtype::net::deltaRecordSize(fields);
+    };
+    std::size_t i = 0, j = 0;
+    while (i < world.size() || j < base.size()) {
+        if (j == base.size() || (i < world.size() && world[i].id < base[j].id)) {
+            pending(&world[i++], nullptr, rtype::net::DeltaAll);
+        } else if (i == world.size() || base[j].id < world[i].id) {
+            pending(nullptr, &base[j++], rtype::net::DeltaRemoved);
+        } else {
+            std::uint8_t fields = rtype::net::diffEntity(base[j], world[i]);
+            if (fields == 0) items_.push_back({&world[i], &base[j], 0, false, 0.f});
+            else pending(&world[i], &base[j], fields);
+            ++i;
+            ++j;
+        }
+    }
+
+    // Over budget: keep the highest priorities, skipping records that no longer fit
+    if (pendingBytes > budgetBytes) {
+        order_.clear();
+        for (std::size_t k = 0; k < items_.size(); ++k)
+            if (items_[k].fields != 0) order_.push_back(k);
+        std::sort(order_.begin(), order_.end(), [&](std::size_t a, std::size_t b) {
+            if (items_[a].priority != items_[b].priority) return items_[a].priority > items_[b].priority;
+            return a < b;
+        });
+        std::size_t used = 0;
+        for (std::size_t k : order_) {
+            const std::size_t size = rtype::net::deltaRecordSize(items_[k].fields);
+            if (used + size <= budgetBytes) used += size;
+            else items_[k].send = false;
+        }
+    }
+
+    // Fragment k covers ids [firstIds[k], firstIds[k + 1] - 1]; headers are written once the count is known
+    std::array<std::uint32_t, rtype::net::MaxSnapshotFragments> firstIds{};
+    std::array<std::uint16_t, rtype::net::MaxSnapshotFragments> counts{};
+    std::size_t used = 0;
+    auto startFragment = [&](std::uint32_t firstId) {
+        if (used == rtype::net::MaxSnapshotFragments) return false;
+        if (fragments.size() <= used) fragments.emplace_back();
+        fragments[used].assign(sizeof(rtype::net::StateDeltaHeader), 0);
+        firstIds[used] = firstId;
+        counts[used] = 0;
+        ++used;
+        return true;
+    };
+    startFragment(0);
+
+    auto emit = [&](const PackedEntity& e, std::uint8_t fields) {
+        const std::size_t size = rtype::net::deltaRecordSize(fields);
+        if (fragments[used - 1].size() + size > fragmentBytes && !startFragment(e.id)) return false;
+        std::vector<char>& f = fragments[used - 1];
+        const std::size_t at = f.size();
+        f.resize(at + size);
+        rtype::net::writeDeltaRecord(f.data() + at, e, fields);
+        ++counts[used - 1];
+        return true;
+    };
+
+    // Emit in id order; the new snapshot is what the client will hold after decoding.
+    // Its slot is neither the baseline's nor any other live one, so its memory is reused.
+    Snapshot& next = history_[snapshotId % kHistory];
+    next.id = snapshotId;
+    std::vector<PackedEntity>& entities = next.entities;
+    entities.clear();
+    for (Item& it : items_) {
+        const PackedEntity& e = it.cur ? *it.cur : *it.base;
+        if (it.fields != 0 && it.send) it.send = emit(e, it.fields);
+        if (it.fields == 0 || it.send) {
+            if (it.cur) entities.push_back(*it.cur);
+        } else {
+            if (it.base) entities.push_back(*it.base);
+            const std::uint32_t id = e.id; // packed member: copy before binding
+            accumNext_.emplace_back(id, it.priority);
+        }
+    }
+    accum_.swap(accumNext_);
+
+    for (std::size_t k = 0; k < used; ++k) {
+        rtype::net::StateDeltaHeader sh{};
+        sh.snapshotId = snapshotId;
+        sh.serverTime = serverTimeMs;
+        sh.baselineId = hasBaseline ? acked_ : 0;
+        sh.inputAck = inputAck_;
+        sh.fragment = static_cast<std::uint8_t>(k);
+        sh.fragmentCount = static_cast<std::uint8_t>(used);
+        sh.firstId = firstIds[k];
+        sh.lastId = k + 1 < used ? firstIds[k + 1] - 1 : std::numeric_limits<std::uint32_t>::max();
+        sh.count = counts[k];
+        std::memcpy(fragments[k].data(), &sh, sizeof(sh));
+    }
+
+    return used;
+}
@@ -1,5 +1,17 @@
 #include "instance/MatchInstance.hpp"
+#include "protocol/UdpServer.hpp"
 
 using namespace rtype::server::instance;
+using rtype::server::gameplay::GameSession;
 
-
+MatchInstance::MatchInstance(asio::io_context& io, rtype::server::UdpServer& udp, rtype::server::TcpServer* tcp,
+                             rtype::server::gameplay::SessionConfig config)
+    : io_(io), id_(config.matchId), out_(udp.socket()) {
+    session_ = std::make_unique<GameSession>(io_,
+        [this](const asio::ip::udp::endpoint& to, const rtype::server::network::PacketRef& packet) {
+            out_.queue(to, packet);
+        },
+        tcp,
+        [this] { out_.flush(); },
+        config);
+}
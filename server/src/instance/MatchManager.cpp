@@ -0,0 +1,118 @@
+#include "instance/MatchManager.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+using namespace rtype::server::instance;
+
+MatchManager::MatchManager(asio::io_context& io, rtype::server::UdpServer& udp, rtype::server::TcpServer* tcp,
+                           std::size_t maxMatches, std::size_t inboxes)
+    : io_(io), udp_(udp), tcp_(tcp), maxMatches_(std::max<std::size_t>(1, maxMatches)),
+      inboxes_(std::max<std::size_t>(1, inboxes)) {
+    matches_.reserve(maxMatches_);
+}
+
+void MatchManager::start() {
+    // The first lobby is ready before anyone connects, as with a single session
+    std::unique_lock lock(mutex_);
+    if (matches_.empty()) createMatch();
+}
+
+MatchManager::~MatchManager() { stop(); }
+
+void MatchManager::stop() {
+    stopped_ = true;
+    std::unique_lock lock(mutex_);
+    for (auto& slot : matches_) slot.match->stop();
+}
+
+std::size_t MatchManager::matchCount() const {
+    std::shared_lock lock(mutex_);
+    return matches_.size();
+}
+
+std::size_t MatchManager::createMatch() {
+    const std::size_t index = matches_.size();
+    rtype::server::gameplay::SessionConfig config;
+    config.matchId = static_cast<std::uint32_t>(index + 1);
+    config.inboxes = inboxes_;
+    if (maxMatches_ > 1) {
+        // Parallelism comes from running matches side by side
+        const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        config.workerThreads = 0;
+        config.cpu = hw > 1 ? static_cast<int>(1 + index % (hw - 1)) : -1;
+    }
+
+    Slot slot;
+    slot.match = std::make_unique<MatchInstance>(io_, udp_, tcp_, config);
+    slot.match->session().setOnClientRemoved([this, index](const asio::ip::udp::endpoint& ep) {
+        asio::post(io_, [this, index, ep] { releaseSeat(index, ep); });
+    });
+    slot.match->start();
+    matches_.push_back(std::move(slot));
+    if (maxMatches_ > 1)
+        std::cout << "[server] Match " << index + 1 << " created (" << matches_.size() << "/" << maxMatches_ << ")\n";
+    return index;
+}
+
+std::size_t MatchManager::pickMatch() {
+    auto open = [](const Slot& s) { return !s.match->session().inMatch() && s.seats < kPlayersPerMatch; };
+    // Fill lobbies that already have players before opening new ones
+    for (std::size_t i = 0; i < matches_.size(); ++i)
+        if (open(matches_[i]) && matches_[i].seats > 0) return i;
+    for (std::size_t i = 0; i < matches_.size(); ++i)
+        if (open(matches_[i])) return i;
+    if (matches_.size() < maxMatches_) return createMatch();
+    // Everything full or playing: join the least crowded match, as a single session would
+    auto it = std::min_element(matches_.begin(), matches_.end(),
+                               [](const Slot& a, const Slot& b) { return a.seats < b.seats; });
+    return static_cast<std::size_t>(it - matches_.begin());
+}
+
+void MatchManager::onTcpHello(const std::string& username, const std::string& ip) {
+    if (stopped_) return;
+    std::unique_lock lock(mutex_);
+    const std::size_t index = pickMatch();
+    ++matches_[index].seats;
+    auto [pending, added] = pendingByIp_.try_emplace(ip, index);
+    if (!added) {
+        // The session forgets a hello superseded by a newer one from the same IP
+        if (matches_[pending->second].seats > 0) --matches_[pending->second].seats;
+        pending->second = index;
+    }
+    matches_[index].match->session().onTcpHello(username, ip);
+}
+
+void MatchManager::onUdpPacket(const asio::ip::udp::endpoint& from, const char* data, std::size_t size,
+                               std::size_t inbox) {
+    if (stopped_) return;
+    const auto key = network::EndpointKey::from(from);
+    MatchInstance* match = nullptr;
+    {
+        std::shared_lock lock(mutex_);
+        auto route = routes_.find(key);
+        if (route != routes_.end()) match = matches_[route->second].match.get();
+    }
+    if (!match) {
+        std::unique_lock lock(mutex_);
+        auto route = routes_.find(key);
+        if (route == routes_.end()) {
+            auto pending = pendingByIp_.find(from.address().to_string());
+            if (pending == pendingByIp_.end()) return; // no hello from there: nobody would bind it
+            // The session binds the endpoint to the player waiting on this IP
+            route = routes_.emplace(key, pending->second).first;
+            pendingByIp_.erase(pending);
+        }
+        match = matches_[route->second].match.get();
+    }
+    // Matches live as long as the manager; the session's inbox is lock-free
+    match->session().onUdpPacket(from, data, size, inbox);
+}
+
+void MatchManager::releaseSeat(std::size_t match, const asio::ip::udp::endpoint& ep) {
+    if (stopped_) return;
+    std::unique_lock lock(mutex_);
+    auto route = routes_.find(network::EndpointKey::from(ep));
+    if (route != routes_.end() && route->second == match) routes_.erase(route);
+    if (matches_[match].seats > 0) --matches_[match].seats;
+}
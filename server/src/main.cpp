@@ -4,6 +4,7 @@
 #include <chrono>
 #include <asio.hpp>
 #include <string>
+#include <algorithm>
 #include "network/NetworkManager.hpp"
 
 int main(int argc, char** argv) {
@@ -21,6 +22,37 @@ int main(int argc, char** argv) {
         }
     }
 
+    // Matches hosted side by side; the default keeps one game thread per core
+    std::size_t maxMatches = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 2) {
+        try {
+            int m = std::stoi(argv[2]);
+            if (m < 1) {
+                std::cerr << "Invalid match count: " << argv[2] << " (must be >= 1). Using default " << maxMatches << ".\n";
+            } else {
+                maxMatches = static_cast<std::size_t>(m);
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << "Invalid match count argument: '" << argv[2] << "' (" << ex.what() << "). Using default "
+                      << maxMatches << ".\n";
+        }
+    }
+
+    // UDP receive shards (SO_REUSEPORT sockets, one thread each); 1 keeps UDP on the main io thread
+    std::size_t udpShards = 1;
+    if (argc > 3) {
+        try {
+            int k = std::stoi(argv[3]);
+            if (k < 1) {
+                std::cerr << "Invalid UDP shard count: " << argv[3] << " (must be >= 1). Using 1.\n";
+            } else {
+                udpShards = static_cast<std::size_t>(k);
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << "Invalid UDP shard count argument: '" << argv[3] << "' (" << ex.what() << "). Using 1.\n";
+        }
+    }
+
     std::string displayIp = "0.0.0.0";
     try {
         asio::io_context probe;
@@ -41,12 +73,14 @@ int main(int argc, char** argv) {
     std::cout << "IP : " << displayIp << "\n";
     std::cout << "PORT (UDP) : " << port << "\n";
     std::cout << "PORT (TCP) : " << (port + 1) << "\n";
+    std::cout << "MATCHES : " << maxMatches << "\n";
+    std::cout << "UDP SHARDS : " << udpShards << "\n";
     std::cout << "###########################\n";
 
     try {
         asio::io_context io;
 
-        rtype::server::network::NetworkManager net(io, port, static_cast<unsigned short>(port + 1));
+        rtype::server::network::NetworkManager net(io, port, static_cast<unsigned short>(port + 1), maxMatches, udpShards);
         net.start();
         io.run();
         return 0;
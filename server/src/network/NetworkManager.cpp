@@ -2,41 +2,66 @@
 #include <iostream>
 
 using namespace rtype::server::network;
-using rtype::server::gameplay::GameSession;
+using rtype::server::instance::MatchManager;
 
-NetworkManager::NetworkManager(asio::io_context& io, unsigned short udpPort, unsigned short tcpPort)
+NetworkManager::NetworkManager(asio::io_context& io, unsigned short udpPort, unsigned short tcpPort, std::size_t maxMatches,
+                               std::size_t udpShards)
     : io_(io) {
     tcp_ = std::make_shared<rtype::server::TcpServer>(io_, tcpPort);
     tcp_->setUdpPort(udpPort);
 
-    udp_ = std::make_unique<rtype::server::UdpServer>(io_, udpPort);
-    udp_->setTcpServer(tcp_.get());
+    if (udpShards <= 1) {
+        udp_.push_back(std::make_unique<rtype::server::UdpServer>(io_, udpPort));
+    } else {
+        // The kernel hashes each client's address to one socket, so a client always lands on the same shard
+        for (std::size_t k = 0; k < udpShards; ++k) {
+            Shard shard;
+            shard.io = std::make_unique<asio::io_context>();
+            udp_.push_back(std::make_unique<rtype::server::UdpServer>(*shard.io, udpPort, true));
+            shards_.push_back(std::move(shard));
+        }
+    }
+    for (auto& udp : udp_) udp->setTcpServer(tcp_.get());
 
-    session_ = std::make_unique<GameSession>(io_,
-        [this](const asio::ip::udp::endpoint& to, const void* data, std::size_t size){
-            udp_->sendRaw(to, data, size);
-        },
-        tcp_.get());
+    // Inbox 0 is the io thread's (hellos), each shard thread gets its own
+    const std::size_t inboxes = 1 + shards_.size();
+    matches_ = std::make_unique<MatchManager>(io_, *udp_.front(), tcp_.get(), maxMatches, inboxes);
 
-    // Bind TCP hello callback to session
+    // Bind TCP hello callback to the match manager, which picks a lobby
     tcp_->setOnHello([this](const std::string& name, const std::string& ip){
-        session_->onTcpHello(name, ip);
+        matches_->onTcpHello(name, ip);
     });
 
-    // Forward all UDP packets to session; first packet binds endpoint automatically
-    udp_->setPacketHandler([this](const asio::ip::udp::endpoint& from, const char* data, std::size_t size){
-        session_->onUdpPacket(from, data, size);
-    });
+    // Forward all UDP packets to their match; first packet binds endpoint automatically
+    for (std::size_t k = 0; k < udp_.size(); ++k) {
+        const std::size_t inbox = shards_.empty() ? 0 : 1 + k;
+        udp_[k]->setPacketHandler([this, inbox](const asio::ip::udp::endpoint& from, const char* data, std::size_t size){
+            matches_->onUdpPacket(from, data, size, inbox);
+        });
+    }
 }
 
+NetworkManager::~NetworkManager() { stop(); }
+
 void NetworkManager::start() {
     tcp_->start();
-    udp_->start();
-    session_->start();
+    for (auto& udp : udp_) udp->start();
+    for (auto& shard : shards_) {
+        asio::io_context* io = shard.io.get();
+        shard.thread = std::thread([io] { io->run(); });
+    }
+    if (!shards_.empty())
+        std::cout << "[server] UDP receive sharded over " << shards_.size() << " sockets\n";
+    matches_->start();
 }
 
 void NetworkManager::stop() {
-    session_->stop();
-    udp_->stop();
+    matches_->stop();
+    // Shard threads are joined before their sockets are closed from here
+    for (auto& shard : shards_) {
+        shard.io->stop();
+        if (shard.thread.joinable()) shard.thread.join();
+    }
+    for (auto& udp : udp_) udp->stop();
     tcp_->stop();
 }
@@ -0,0 +1,36 @@
+#include "network/PacketPool.hpp"
+
+using namespace rtype::server::network;
+
+PacketPool::PacketPool(std::size_t initialBuffers) {
+    chunks_.reserve(16);
+    ++allocations_;
+    grow(initialBuffers);
+}
+
+PacketRef PacketPool::acquire() {
+    // Double the pool: a burst costs a few allocations, not one per datagram
+    if (!free_) grow(capacity_ > 0 ? capacity_ : 1);
+    PacketBuffer* buf = free_;
+    free_ = buf->nextFree;
+    buf->nextFree = nullptr;
+    buf->size = 0;
+    return PacketRef(buf);
+}
+
+void PacketPool::release(PacketBuffer* buf) {
+    buf->nextFree = free_;
+    free_ = buf;
+}
+
+void PacketPool::grow(std::size_t count) {
+    if (chunks_.size() == chunks_.capacity()) ++allocations_;
+    auto chunk = std::make_unique<PacketBuffer[]>(count);
+    ++allocations_;
+    for (std::size_t i = 0; i < count; ++i) {
+        chunk[i].pool = this;
+        release(&chunk[i]);
+    }
+    chunks_.push_back(std::move(chunk));
+    capacity_ += count;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <iostream>
+
+// Minimal checks for the unit tests. A failed CHECK reports its location and
+// the test carries on; main() returns rtype::test::result() so CTest sees the failure.
+namespace rtype::test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline int result() {
+    if (failures() != 0) std::cerr << failures() << " check(s) failed\n";
+    return failures() == 0 ? 0 : 1;
+}
+
+}
+
+#define CHECK(cond)                                                                    \
+    do {                                                                               \
+        if (!(cond)) {                                                                 \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+            ++rtype::test::failures();                                                 \
+        }                                                                              \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                              \
+    do {                                                                                            \
+        const auto& check_a_ = (a);                                                                 \
+        const auto& check_b_ = (b);                                                                 \
+        if (!(check_a_ == check_b_)) {                                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #a ", " #b ") failed: "       \
+                      << check_a_ << " != " << check_b_ << "\n";                                    \
+            ++rtype::test::failures();                                                              \
+        }                                                                                           \
+    } while (0)
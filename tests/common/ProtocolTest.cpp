@@ -0,0 +1,182 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "Check.hpp"
+#include "common/Protocol.hpp"
+
+using namespace rtype::net;
+
+namespace {
+
+bool samePacked(const PackedEntity& a, const PackedEntity& b) {
+    return a.id == b.id && diffEntity(a, b) == 0;
+}
+
+void testPositions() {
+    // Every step of the grid survives the trip; values in between land within half a step
+    for (float v : {-512.f, -100.f, 0.f, 0.0625f, 123.4375f, 480.f, 959.9375f, 3000.f})
+        CHECK_EQ(dequantizePosition(quantizePosition(v)), v);
+    for (float v : {0.03f, 17.1f, 599.99f, -33.3f})
+        CHECK(std::abs(dequantizePosition(quantizePosition(v)) - v) <= 0.5f / PositionScale);
+    // Out of range and NaN clamp to the ends
+    CHECK_EQ(quantizePosition(-10000.f), std::uint16_t{0});
+    CHECK_EQ(quantizePosition(100000.f), std::uint16_t{65535});
+    CHECK_EQ(quantizePosition(std::numeric_limits<float>::quiet_NaN()), std::uint16_t{0});
+}
+
+void testVelocities() {
+    const float cases[][2] = {{0.f, 0.f}, {1.f, -1.f}, {-320.f, 150.f}, {2047.f, -2048.f}, {-2048.f, 2047.f}, {12.4f, -12.6f}};
+    for (const auto& c : cases) {
+        std::uint8_t packed[3];
+        packVelocity(c[0], c[1], packed);
+        float vx = 0.f, vy = 0.f;
+        unpackVelocity(packed, vx, vy);
+        CHECK_EQ(vx, std::round(c[0]));
+        CHECK_EQ(vy, std::round(c[1]));
+    }
+    // Clamped to 12 bits; NaN reads back as still
+    std::uint8_t packed[3];
+    packVelocity(1e6f, -1e6f, packed);
+    float vx = 0.f, vy = 0.f;
+    unpackVelocity(packed, vx, vy);
+    CHECK_EQ(vx, static_cast<float>(VelocityLimit));
+    CHECK_EQ(vy, static_cast<float>(-VelocityLimit - 1));
+    packVelocity(std::numeric_limits<float>::quiet_NaN(), 5.f, packed);
+    unpackVelocity(packed, vx, vy);
+    CHECK_EQ(vx, 0.f);
+    CHECK_EQ(vy, 5.f);
+}
+
+void testPalette() {
+    for (std::size_t i = 0; i < EntityPalette.size(); ++i) {
+        CHECK_EQ(paletteIndex(EntityPalette[i]), static_cast<std::uint8_t>(i));
+        CHECK_EQ(paletteColor(static_cast<std::uint8_t>(i)), EntityPalette[i]);
+    }
+    // Off-palette colours map to the nearest entry, unknown indices to the default
+    CHECK_EQ(paletteColor(paletteIndex(0x56ABFEFFu)), EntityPalette[1]);
+    CHECK_EQ(paletteColor(200), EntityPalette[0]);
+}
+
+void testDeltaRecords() {
+    const PackedEntity base = packEntity(42, EntityType::Enemy, 700.f, 300.f, -120.f, 0.f, 0xFF5555FFu);
+    PackedEntity cur = base;
+    CHECK_EQ(diffEntity(base, cur), std::uint8_t{0});
+    cur.y = quantizePosition(310.f);
+    packVelocity(-120.f, 35.f, cur.vel);
+    const std::uint8_t fields = diffEntity(base, cur);
+    CHECK_EQ(fields, std::uint8_t{DeltaY | DeltaVel});
+
+    // Only the changed fields travel; the rest comes from the baseline
+    char buf[MaxDeltaRecordSize];
+    const std::size_t size = writeDeltaRecord(buf, cur, fields);
+    CHECK_EQ(size, deltaRecordSize(fields));
+    CHECK_EQ(size, std::size_t{4 + 1 + 2 + 3});
+    std::uint32_t id = 0;
+    std::uint8_t readFields = 0;
+    PackedEntity out = base;
+    CHECK_EQ(readDeltaRecord(buf, size, id, readFields, out), size);
+    CHECK_EQ(id, std::uint32_t{42});
+    CHECK_EQ(readFields, fields);
+    CHECK(samePacked(out, cur));
+
+    // A full record rebuilds the entity from nothing
+    CHECK_EQ(deltaRecordSize(DeltaAll), MaxDeltaRecordSize);
+    const std::size_t full = writeDeltaRecord(buf, cur, DeltaAll);
+    CHECK_EQ(full, MaxDeltaRecordSize);
+    PackedEntity fresh{};
+    CHECK_EQ(readDeltaRecord(buf, full, id, readFields, fresh), full);
+    CHECK(samePacked(fresh, cur));
+
+    // A removal is the id and mask only
+    CHECK_EQ(writeDeltaRecord(buf, cur, DeltaRemoved), std::size_t{5});
+    CHECK_EQ(readDeltaRecord(buf, 5, id, readFields, fresh), std::size_t{5});
+    CHECK_EQ(readFields, std::uint8_t{DeltaRemoved});
+
+    // Truncated records are rejected without touching the entity
+    writeDeltaRecord(buf, cur, DeltaAll);
+    for (std::size_t n = 0; n < full; ++n) {
+        PackedEntity untouched = base;
+        CHECK_EQ(readDeltaRecord(buf, n, id, readFields, untouched), std::size_t{0});
+        CHECK(samePacked(untouched, base));
+    }
+}
+
+void testRecordStream() {
+    // Records packed back to back read back in order, as in a StateDelta payload
+    const PackedEntity ents[] = {
+        packEntity(1, EntityType::Player, 50.f, 100.f, 0.f, 150.f, EntityPalette[1]),
+        packEntity(7, EntityType::Bullet, 80.f, 104.f, 600.f, 0.f, EntityPalette[2]),
+        packEntity(9, EntityType::Powerup, 900.f, 20.f, -60.f, 0.f, EntityPalette[10]),
+    };
+    const std::uint8_t masks[] = {DeltaX | DeltaY, DeltaAll, DeltaRemoved};
+    char buf[3 * MaxDeltaRecordSize];
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < 3; ++i) size += writeDeltaRecord(buf + size, ents[i], masks[i]);
+
+    const char* p = buf;
+    std::size_t left = size;
+    for (std::size_t i = 0; i < 3; ++i) {
+        std::uint32_t id = 0;
+        std::uint8_t fields = 0;
+        PackedEntity e = ents[i];
+        e.x = e.y = 0;
+        const std::size_t used = readDeltaRecord(p, left, id, fields, e);
+        CHECK_EQ(used, deltaRecordSize(masks[i]));
+        CHECK_EQ(id, std::uint32_t{ents[i].id});
+        CHECK_EQ(fields, masks[i]);
+        if (!(fields & DeltaRemoved)) CHECK(samePacked(e, ents[i]));
+        if (used == 0) return;
+        p += used;
+        left -= used;
+    }
+    CHECK_EQ(left, std::size_t{0});
+}
+
+void testMergeRecords() {
+    std::vector<PackedEntity> base;
+    for (std::uint32_t id : {2u, 4u, 6u, 8u, 10u})
+        base.push_back(packEntity(id, EntityType::Enemy, 100.f * id, 50.f, 0.f, 0.f, EntityPalette[4]));
+    // Fragment [3, 8]: 4 moves, 5 spawns, 6 leaves; 8 is unchanged
+    PackedEntity moved = base[1];
+    moved.x = quantizePosition(999.f);
+    const PackedEntity spawned = packEntity(5, EntityType::Bullet, 1.f, 2.f, 300.f, 0.f, EntityPalette[2]);
+    char buf[3 * MaxDeltaRecordSize];
+    std::size_t size = writeDeltaRecord(buf, moved, DeltaX);
+    size += writeDeltaRecord(buf + size, spawned, DeltaAll);
+    size += writeDeltaRecord(buf + size, base[2], DeltaRemoved);
+
+    std::vector<PackedEntity> out;
+    CHECK(mergeDeltaRecords(base, 3, 8, buf, size, 3, out));
+    // Only the fragment's range comes out, baseline entries included
+    CHECK_EQ(out.size(), std::size_t{3});
+    if (out.size() == 3) {
+        CHECK(samePacked(out[0], moved));
+        CHECK(samePacked(out[1], spawned));
+        CHECK(samePacked(out[2], base[3]));
+    }
+
+    // A record outside the range or cut short rejects the fragment
+    out.clear();
+    CHECK(!mergeDeltaRecords(base, 5, 8, buf, size, 3, out));
+    out.clear();
+    CHECK(!mergeDeltaRecords(base, 3, 8, buf, size - 1, 3, out));
+    // No records: the baseline range as is
+    out.clear();
+    CHECK(mergeDeltaRecords(base, 0, 7, buf, 0, 0, out));
+    CHECK_EQ(out.size(), std::size_t{3});
+}
+
+}
+
+int main() {
+    testPositions();
+    testVelocities();
+    testPalette();
+    testDeltaRecords();
+    testRecordStream();
+    testMergeRecords();
+    return rtype::test::result();
+}
@@ -0,0 +1,135 @@
+#include <cstddef>
+#include <vector>
+#include "Check.hpp"
+#include "rt/ecs/Registry.hpp"
+
+using rt::ecs::CommandBuffer;
+using rt::ecs::Entity;
+using rt::ecs::Registry;
+
+namespace {
+
+struct A { int v = 0; };
+struct B { float x = 0.f; float y = 0.f; };
+struct Link { int tag = 0; Entity target = 0; };
+
+void testPlaceholdersResolve() {
+    Registry r;
+    Entity existing = r.create();
+    CommandBuffer cmd;
+    Entity p0 = cmd.create();
+    Entity p1 = cmd.create();
+    CHECK(CommandBuffer::isPlaceholder(p0));
+    CHECK(p0 != p1);
+    cmd.emplace<A>(p0, {1});
+    cmd.emplace<B>(p1, {2.f, 3.f});
+    cmd.emplace<A>(p1, {4});
+    cmd.emplace<A>(existing, {5});
+    CHECK_EQ(cmd.size(), std::size_t{6});
+    // Nothing happens before the playback
+    CHECK_EQ(r.alive().size(), std::size_t{1});
+
+    cmd.flush(r);
+    CHECK(cmd.empty());
+    CHECK_EQ(r.alive().size(), std::size_t{3});
+    CHECK_EQ(r.storage<A>().size(), std::size_t{3});
+    CHECK_EQ(r.storage<B>().size(), std::size_t{1});
+    CHECK_EQ(r.get<A>(existing)->v, 5);
+    // Each placeholder became its own entity, with the components recorded for it
+    for (auto [e, b] : r.storage<B>()) {
+        CHECK(!CommandBuffer::isPlaceholder(e));
+        CHECK_EQ(b.x, 2.f);
+        CHECK_EQ(b.y, 3.f);
+        CHECK_EQ(r.get<A>(e)->v, 4);
+    }
+    int ones = 0;
+    for (auto [e, a] : r.storage<A>()) ones += a.v == 1 && !r.get<B>(e);
+    CHECK_EQ(ones, 1);
+
+    // Placeholders restart with every round; the buffer is reusable
+    Entity again = cmd.create();
+    CHECK_EQ(again, p0);
+    cmd.emplace<A>(again, {6});
+    cmd.flush(r);
+    CHECK_EQ(r.alive().size(), std::size_t{4});
+}
+
+void testDestroysRunLast() {
+    Registry r;
+    Entity e = r.create();
+    CommandBuffer cmd;
+    Entity p = cmd.create();
+    cmd.destroy(e);
+    cmd.emplace<A>(e, {1}); // recorded after the destroy, still applied before it
+    cmd.emplace<A>(p, {2});
+    cmd.destroy(p);         // a placeholder can be destroyed in the same round
+    cmd.flush(r);
+    CHECK(!r.valid(e));
+    CHECK(r.alive().empty());
+    CHECK(r.storage<A>().empty());
+}
+
+void testHandleMembersResolve() {
+    Registry r;
+    Entity existing = r.create();
+    CommandBuffer cmd;
+    Entity origin = cmd.create();
+    cmd.emplace<A>(origin, {7});
+    Entity follower = cmd.create();
+    cmd.emplace<Link>(follower, {1, origin}, &Link::target);
+    // Real handles are kept as they are
+    cmd.emplace<Link>(existing, {2, existing}, &Link::target);
+    cmd.flush(r);
+
+    CHECK_EQ(r.storage<Link>().size(), std::size_t{2});
+    for (auto [e, link] : r.storage<Link>()) {
+        CHECK(r.valid(link.target));
+        if (link.tag == 1) {
+            CHECK(e != existing);
+            CHECK(r.get<A>(link.target) != nullptr && r.get<A>(link.target)->v == 7);
+        } else {
+            CHECK_EQ(link.target, existing);
+        }
+    }
+}
+
+void testBatchedDestroySkipsStaleAndDuplicates() {
+    Registry r;
+    Entity stale = r.create();
+    r.destroy(stale);
+    // Hand the index of `stale` to a new owner
+    std::vector<Entity> spare;
+    for (std::size_t i = 0; i < Registry::kMinFreeIndices; ++i) spare.push_back(r.create());
+    for (Entity s : spare) r.destroy(s);
+    Entity owner = r.create();
+    CHECK_EQ(rt::ecs::entityIndex(owner), rt::ecs::entityIndex(stale));
+    r.emplace<A>(owner, {1});
+    Entity victim = r.create();
+    r.emplace<A>(victim, {2});
+    r.emplace<B>(victim, {});
+
+    CommandBuffer cmd;
+    cmd.destroy(victim);
+    cmd.destroy(victim);
+    cmd.destroy(stale);
+    cmd.emplace<B>(stale, {}); // dropped: the handle is not alive
+    cmd.flush(r);
+
+    CHECK(!r.valid(victim));
+    CHECK(r.valid(owner));
+    CHECK_EQ(r.get<A>(owner)->v, 1);
+    CHECK(r.get<B>(owner) == nullptr);
+    CHECK_EQ(r.storage<A>().size(), std::size_t{1});
+    CHECK(r.storage<B>().empty());
+    CHECK_EQ(r.alive().size(), std::size_t{1});
+}
+
+}
+
+int main() {
+    testPlaceholdersResolve();
+    testDestroysRunLast();
+    testHandleMembersResolve();
+    testBatchedDestroySkipsStaleAndDuplicates();
+    return rtype::test::result();
+}
@@ -0,0 +1,150 @@
+#include <cstddef>
+#include <vector>
+#include "Check.hpp"
+#include "rt/ecs/Registry.hpp"
+
+using rt::ecs::Entity;
+using rt::ecs::Registry;
+
+namespace {
+
+struct A { int v = 0; };
+struct B { int v = 0; };
+
+// Destroys `n` fresh entities, enough for the free list to start handing indices back
+std::vector<Entity> churn(Registry& r, std::size_t n) {
+    std::vector<Entity> out;
+    for (std::size_t i = 0; i < n; ++i) out.push_back(r.create());
+    for (Entity e : out) r.destroy(e);
+    return out;
+}
+
+void testIndicesComeBackOldestFirst() {
+    Registry r;
+    const auto freed = churn(r, Registry::kMinFreeIndices + 2);
+    // Past the threshold, the oldest freed index comes back with its version bumped
+    for (std::size_t i = 0; i < 2; ++i) {
+        Entity e = r.create();
+        CHECK_EQ(rt::ecs::entityIndex(e), rt::ecs::entityIndex(freed[i]));
+        CHECK_EQ(rt::ecs::entityVersion(e), rt::ecs::entityVersion(freed[i]) + 1);
+        CHECK(e != freed[i]);
+        CHECK(r.valid(e));
+        CHECK(!r.valid(freed[i]));
+    }
+    // Down to it, new indices are appended
+    Entity fresh = r.create();
+    CHECK(rt::ecs::entityIndex(fresh) > rt::ecs::entityIndex(freed.back()));
+    CHECK_EQ(rt::ecs::entityVersion(fresh), Entity{0});
+}
+
+void testStaleHandles() {
+    Registry r;
+    Entity old = r.create();
+    r.emplace<A>(old, {1});
+    r.emplace<B>(old, {2});
+    r.destroy(old);
+    CHECK(!r.valid(old));
+    CHECK(r.get<A>(old) == nullptr);
+    CHECK_EQ(r.signature(old), rt::ecs::Signature{0});
+
+    // Recycle the index of `old` to a new owner
+    churn(r, Registry::kMinFreeIndices);
+    Entity now = r.create();
+    CHECK_EQ(rt::ecs::entityIndex(now), rt::ecs::entityIndex(old));
+    r.emplace<A>(now, {3});
+
+    // The old handle sees nothing of the new owner and cannot touch it
+    CHECK(r.get<A>(old) == nullptr);
+    r.destroy(old);
+    CHECK(r.valid(now));
+    CHECK_EQ(r.get<A>(now)->v, 3);
+#ifdef NDEBUG
+    // Asserted in debug builds; a release build leaves the new owner alone
+    CHECK(r.emplace<B>(old, {4}) == nullptr);
+    CHECK(r.get<B>(now) == nullptr);
+    CHECK_EQ(r.get<A>(now)->v, 3);
+#endif
+
+    // Destroying twice, in one batch or not, only frees the slot once
+    std::vector<Entity> batch{now, now, old};
+    r.destroy(batch);
+    CHECK(!r.valid(now));
+    CHECK(r.get<A>(now) == nullptr);
+    CHECK(r.alive().size() == 0);
+}
+
+void testVersionWrapsPastPlaceholder() {
+    Registry r;
+    Entity e = r.create();
+    const Entity index = rt::ecs::entityIndex(e);
+    // Keep enough other indices queued that `index` comes back on every lap
+    std::vector<Entity> spare;
+    for (std::size_t i = 0; i < Registry::kMinFreeIndices; ++i) spare.push_back(r.create());
+    for (Entity s : spare) r.destroy(s);
+
+    bool wrapped = false;
+    for (Entity lap = 0; lap < rt::ecs::kEntityVersionMask; ++lap) {
+        Entity before = rt::ecs::entityVersion(e);
+        r.destroy(e);
+        // Cycle the free list until our index is handed out again
+        do {
+            e = r.create();
+            if (rt::ecs::entityIndex(e) != index) r.destroy(e);
+        } while (rt::ecs::entityIndex(e) != index);
+        CHECK(rt::ecs::entityVersion(e) != rt::ecs::kPlaceholderVersion);
+        CHECK(!rt::ecs::CommandBuffer::isPlaceholder(e));
+        if (rt::ecs::entityVersion(e) == 0) {
+            CHECK_EQ(before, rt::ecs::kPlaceholderVersion - 1);
+            wrapped = true;
+        } else {
+            CHECK_EQ(rt::ecs::entityVersion(e), before + 1);
+        }
+    }
+    CHECK(wrapped);
+    CHECK(r.valid(e));
+}
+
+void testAlignOnlyMovesFirstPool() {
+    Registry r;
+    std::vector<Entity> es;
+    for (int i = 0; i < 8; ++i) {
+        Entity e = r.create();
+        es.push_back(e);
+        if (i % 3 != 0) r.emplace<A>(e, {i}); // some entities have only a B
+    }
+    // B in reverse creation order, every entity except the last one
+    for (int i = 6; i >= 0; --i) r.emplace<B>(es[static_cast<std::size_t>(i)], {i});
+    Entity lonely = r.create();
+    r.emplace<A>(lonely, {99});
+    const std::vector<Entity> bOrder = r.storage<B>().entities();
+
+    std::size_t n = r.align<A, B>();
+    // Stops at the first B without an A: es[6]
+    CHECK_EQ(n, std::size_t{0});
+    CHECK(r.storage<B>().entities() == bOrder);
+
+    // Without B-only entities the whole B pool lines up
+    for (int i = 0; i < 7; i += 3) r.remove<B>(es[static_cast<std::size_t>(i)]);
+    const std::vector<Entity> bAfter = r.storage<B>().entities();
+    n = r.align<A, B>();
+    CHECK_EQ(n, r.storage<B>().size());
+    CHECK(r.storage<B>().entities() == bAfter);
+    for (std::size_t i = 0; i < n; ++i) {
+        CHECK_EQ(r.storage<A>().entities()[i], bAfter[i]);
+        CHECK_EQ(r.storage<A>().components()[i].v, r.storage<B>().components()[i].v);
+    }
+    CHECK_EQ(r.get<A>(lonely)->v, 99);
+    // Stable once aligned
+    CHECK_EQ((r.align<A, B>()), n);
+    CHECK(r.storage<A>().entities()[0] == bAfter[0]);
+}
+
+}
+
+int main() {
+    testIndicesComeBackOldestFirst();
+    testStaleHandles();
+    testVersionWrapsPastPlaceholder();
+    testAlignOnlyMovesFirstPool();
+    return rtype::test::result();
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Check.hpp"
+#include "rt/ecs/Registry.hpp"
+#include "rt/game/Systems.hpp"
+
+using rt::ecs::Access;
+using rt::ecs::Entity;
+using rt::ecs::Registry;
+
+namespace {
+
+struct A { int v = 0; };
+struct B { int v = 0; };
+
+// Declares whatever it is given; destroys every A when `despawn` is set
+class Probe : public rt::ecs::System {
+  public:
+    Probe(bool readsB, bool despawn) : readsB_(readsB), despawn_(despawn) {}
+    void update(Registry& r, float) override {
+        if (!despawn_) return;
+        for (auto [e, a] : r.storage<A>()) r.commands().destroy(e);
+    }
+    bool declareAccess(Access& a) const override {
+        if (readsB_) a.reads<B>();
+        else a.reads<A>();
+        if (despawn_) a.structural();
+        return true;
+    }
+
+  private:
+    bool readsB_;
+    bool despawn_;
+};
+
+void testStructuralEndsStage() {
+    Registry r;
+    std::vector<std::unique_ptr<rt::ecs::System>> systems;
+    systems.push_back(std::make_unique<Probe>(false, false)); // 0: reads A
+    systems.push_back(std::make_unique<Probe>(false, true));  // 1: reads A, despawns
+    systems.push_back(std::make_unique<Probe>(true, false));  // 2: reads B only
+    systems.push_back(std::make_unique<Probe>(false, false)); // 3: reads A
+    rt::ecs::Scheduler s(1);
+    s.build(r, systems);
+    const auto& stages = s.stages();
+    CHECK_EQ(stages.size(), std::size_t{2});
+    if (stages.size() != 2) return;
+    // Readers share a stage; nothing registered after the despawn runs beside it
+    CHECK(stages[0] == (std::vector<std::size_t>{0, 1}));
+    CHECK(stages[1] == (std::vector<std::size_t>{2, 3}));
+}
+
+// Clears the screen of enemies on the ticks the players release their beams:
+// the next tick must not see those enemies any more
+class FieldClear : public rt::ecs::System {
+  public:
+    void update(Registry& r, float) override {
+        if (tick_++ % 90 != 60) return;
+        for (auto [e, tag, t] : r.view<rt::game::EnemyTag, rt::game::Transform>())
+            if (t.x < 1000.f) r.commands().destroy(e);
+    }
+    bool declareAccess(Access& a) const override {
+        a.reads<rt::game::EnemyTag, rt::game::Transform>().structural();
+        return true;
+    }
+
+  private:
+    int tick_ = 0;
+};
+
+// What a tick leaves behind, comparable across runs
+struct EntityState {
+    Entity e;
+    float x, y;
+    std::int32_t score;
+    bool operator==(const EntityState&) const = default;
+};
+
+// The server's system list (plus FieldClear) over a scripted match
+std::vector<EntityState> runMatch(unsigned workers, int ticks) {
+    using namespace rt::game;
+    Registry r;
+    SpatialGrid grid;
+    std::vector<BeamEvent> beams;
+    std::mt19937 rng(7);
+    float elapsed = 0.f;
+    std::int32_t teamScore = 0;
+    r.setWorkerThreads(workers);
+    addMatchSystems(r, grid, beams, rng, &elapsed, &teamScore);
+    r.addSystem(std::make_unique<FieldClear>());
+    for (int p = 0; p < 4; ++p) {
+        auto e = r.create();
+        r.emplace<Transform>(e, {50.f, 100.f + p * 100.f});
+        r.emplace<Velocity>(e, {});
+        r.emplace<NetType>(e, {rtype::net::EntityType::Player});
+        r.emplace<ColorRGBA>(e, {});
+        r.emplace<PlayerInput>(e, {0, 150.f});
+        r.emplace<Shooter>(e, {});
+        r.emplace<ChargeGun>(e, {});
+        r.emplace<Size>(e, {20.f, 12.f});
+        r.emplace<Score>(e, {});
+    }
+    for (int t = 0; t < ticks; ++t) {
+        elapsed += 1.f / 60.f;
+        // Charge for a second, then shoot, while drifting up and down
+        std::uint8_t bits = (t % 90 < 60) ? rtype::net::InputCharge : rtype::net::InputShoot;
+        bits |= (t / 120) % 2 ? rtype::net::InputUp : rtype::net::InputDown;
+        for (auto [e, in] : r.storage<PlayerInput>()) in.bits = bits;
+        r.update(1.f / 60.f);
+        beams.clear();
+        teamScore = 0;
+        for (auto [e, sc] : r.storage<Score>()) teamScore += sc.value;
+    }
+
+    std::vector<EntityState> out;
+    for (Entity e : r.alive()) {
+        const auto* t = r.get<Transform>(e);
+        const auto* sc = r.get<Score>(e);
+        out.push_back({e, t ? t->x : 0.f, t ? t->y : 0.f, sc ? sc->value : 0});
+    }
+    std::sort(out.begin(), out.end(), [](const EntityState& a, const EntityState& b) { return a.e < b.e; });
+    return out;
+}
+
+// The stages the server's tick actually runs in
+void testMatchStages() {
+    using namespace rt::game;
+    Registry r;
+    SpatialGrid grid;
+    std::vector<BeamEvent> beams;
+    std::mt19937 rng(7);
+    float elapsed = 0.f;
+    std::int32_t teamScore = 0;
+    r.setWorkerThreads(8);
+    addMatchSystems(r, grid, beams, rng, &elapsed, &teamScore);
+    r.update(1.f / 60.f);
+    CHECK(r.scheduler() != nullptr);
+    if (!r.scheduler()) return;
+    // Registration order of addMatchSystems, as system indices
+    enum : std::size_t {
+        Input, Invincibility, InfiniteFire, Shooting, Formation, FormationSpawn, Movement, PowerupSpawn,
+        EnemyShooting, DespawnOffscreen, Broadphase, DespawnOutOfBounds, ChargeShooting, Collision,
+        PowerupCollision
+    };
+    const std::vector<std::vector<std::size_t>> expected{
+        {Input, Invincibility, InfiniteFire},
+        {Shooting},
+        {Formation, FormationSpawn},
+        {Movement, PowerupSpawn},
+        {EnemyShooting},
+        {DespawnOffscreen},
+        {Broadphase, DespawnOutOfBounds},
+        {ChargeShooting},
+        {Collision},
+        {PowerupCollision},
+    };
+    CHECK(r.scheduler()->stages() == expected);
+    // Only as many workers as the widest stage can use next to the caller
+    CHECK_EQ(r.scheduler()->workers(), 2u);
+}
+
+void testWorkersMatchSequential() {
+    const auto sequential = runMatch(0, 1800);
+    const auto parallel = runMatch(2, 1800);
+    CHECK(sequential.size() > 4); // the match did spawn things
+    CHECK_EQ(parallel.size(), sequential.size());
+    const std::size_t n = std::min(parallel.size(), sequential.size());
+    for (std::size_t i = 0; i < n; ++i) {
+        if (parallel[i] == sequential[i]) continue;
+        CHECK_EQ(parallel[i].e, sequential[i].e);
+        CHECK_EQ(parallel[i].x, sequential[i].x);
+        CHECK_EQ(parallel[i].y, sequential[i].y);
+        CHECK_EQ(parallel[i].score, sequential[i].score);
+        break;
+    }
+}
+
+}
+
+int main() {
+    testStructuralEndsStage();
+    testMatchStages();
+    testWorkersMatchSequential();
+    return rtype::test::result();
+}
@@ -0,0 +1,49 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Check.hpp"
+#include "rt/ecs/Registry.hpp"
+#include "rt/game/Systems.hpp"
+
+using namespace rt::game;
+using rt::ecs::Entity;
+using rt::ecs::Registry;
+
+namespace {
+
+// Two players release a charged beam on the same tick through the same enemy
+void testTwoBeamsKillOnce() {
+    Registry r;
+    SpatialGrid grid;
+    std::vector<BeamEvent> beams;
+    r.addSystem(std::make_unique<BroadphaseSystem>(grid));
+    r.addSystem(std::make_unique<ChargeShootingSystem>(grid, beams));
+    std::vector<Entity> players;
+    for (int p = 0; p < 2; ++p) {
+        auto e = r.create();
+        r.emplace<Transform>(e, {50.f + p * 20.f, 300.f});
+        r.emplace<PlayerInput>(e, {0, 150.f}); // charge button released
+        r.emplace<ChargeGun>(e, {1.f, 2.f, false});
+        r.emplace<Size>(e, {20.f, 12.f});
+        r.emplace<Score>(e, {});
+        players.push_back(e);
+    }
+    auto enemy = r.create();
+    r.emplace<Transform>(enemy, {500.f, 300.f});
+    r.emplace<Size>(enemy, {27.f, 18.f});
+    r.emplace<EnemyTag>(enemy, {});
+
+    r.update(1.f / 60.f);
+    CHECK_EQ(beams.size(), std::size_t{2});
+    CHECK(!r.valid(enemy));
+    std::int32_t total = 0;
+    for (Entity p : players) total += r.get<Score>(p)->value;
+    CHECK_EQ(total, 50);
+}
+
+}
+
+int main() {
+    testTwoBeamsKillOnce();
+    return rtype::test::result();
+}
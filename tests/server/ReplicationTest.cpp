@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+#include "Check.hpp"
+#include "gameplay/Replication.hpp"
+
+using namespace rtype::net;
+using rtype::server::gameplay::ClientReplication;
+
+namespace {
+
+using World = std::vector<PackedEntity>;
+
+bool sameWorld(const World& a, const World& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (a[i].id != b[i].id || diffEntity(a[i], b[i]) != 0) return false;
+    return true;
+}
+
+// Reads one fragment's header and merges its records onto `base`, as UdpLink does
+bool decodeFragment(const std::vector<char>& frag, const World& base, StateDeltaHeader& sh, World& out) {
+    if (frag.size() < sizeof(sh)) return false;
+    std::memcpy(&sh, frag.data(), sizeof(sh));
+    return mergeDeltaRecords(base, sh.firstId, sh.lastId, frag.data() + sizeof(sh), frag.size() - sizeof(sh), sh.count, out);
+}
+
+// The client side: decoded snapshots by id, usable as baselines
+struct Client {
+    std::map<std::uint32_t, World> decoded;
+
+    // Decodes a complete snapshot; false when its baseline is unknown or a fragment is malformed
+    bool decode(const std::vector<std::vector<char>>& frags, std::size_t count, World& out) {
+        out.clear();
+        std::uint32_t snapshotId = 0;
+        std::uint32_t nextFirst = 0;
+        for (std::size_t k = 0; k < count; ++k) {
+            StateDeltaHeader sh{};
+            std::memcpy(&sh, frags[k].data(), sizeof(sh));
+            static const World kEmpty;
+            const World* base = &kEmpty;
+            if (sh.baselineId != 0) {
+                auto found = decoded.find(sh.baselineId);
+                if (found == decoded.end()) return false;
+                base = &found->second;
+            }
+            // The ranges are contiguous and cover every id
+            CHECK_EQ(std::uint32_t{sh.firstId}, nextFirst);
+            CHECK_EQ(std::size_t{sh.fragment}, k);
+            CHECK_EQ(std::size_t{sh.fragmentCount}, count);
+            if (!decodeFragment(frags[k], *base, sh, out)) return false;
+            nextFirst = sh.lastId + 1;
+            snapshotId = sh.snapshotId;
+        }
+        CHECK_EQ(nextFirst, std::uint32_t{0}); // the last range ends at the largest id
+        decoded[snapshotId] = out;
+        return true;
+    }
+};
+
+PackedEntity randomEntity(std::mt19937& rng, std::uint32_t id) {
+    std::uniform_real_distribution<float> x(-100.f, 1000.f), y(-50.f, 650.f), v(-400.f, 400.f);
+    const auto type = static_cast<EntityType>(1 + rng() % 4);
+    return packEntity(id, type, x(rng), y(rng), v(rng), v(rng), EntityPalette[rng() % EntityPalette.size()]);
+}
+
+// Moves some entities, removes a few and spawns new ones with growing ids
+void step(World& world, std::mt19937& rng, std::uint32_t& nextId) {
+    World next;
+    for (const PackedEntity& e : world) {
+        const unsigned roll = rng() % 100;
+        if (roll < 5) continue;
+        PackedEntity moved = e;
+        if (roll < 60) moved.x = static_cast<std::uint16_t>(moved.x + 1 + rng() % 40);
+        if (roll < 30) packVelocity(static_cast<float>(rng() % 200) - 100.f, 0.f, moved.vel);
+        next.push_back(moved);
+    }
+    const unsigned spawns = rng() % 6;
+    for (unsigned s = 0; s < spawns; ++s) next.push_back(randomEntity(rng, nextId++));
+    world.swap(next);
+}
+
+void testRoundTrip() {
+    std::mt19937 rng(3);
+    std::uint32_t nextId = 1;
+    World world;
+    for (int i = 0; i < 300; ++i) world.push_back(randomEntity(rng, nextId++));
+
+    ClientReplication rep;
+    Client client;
+    std::vector<std::vector<char>> frags;
+    World got;
+    std::size_t multiFragment = 0;
+    for (std::uint32_t snap = 1; snap <= 200; ++snap) {
+        step(world, rng, nextId);
+        // No budget limit: every snapshot decodes to the world exactly
+        const std::size_t n = rep.encode(snap, snap * 16, world, frags, 1200, 1u << 20);
+        CHECK(n >= 1 && n <= MaxSnapshotFragments);
+        for (std::size_t k = 0; k < n; ++k) CHECK(frags[k].size() <= 1200);
+        multiFragment += n > 1;
+        CHECK(client.decode(frags, n, got));
+        CHECK(sameWorld(got, world));
+        // Acks arrive for two snapshots out of three
+        if (snap % 3 != 0) rep.acknowledge(snap);
+    }
+    CHECK(multiFragment > 0);
+}
+
+void testFragmentsStandAlone() {
+    std::mt19937 rng(5);
+    std::uint32_t nextId = 1;
+    World world;
+    for (int i = 0; i < 400; ++i) world.push_back(randomEntity(rng, nextId++));
+    ClientReplication rep;
+    std::vector<std::vector<char>> frags;
+    const std::size_t n = rep.encode(1, 0, world, frags, 1000, 1u << 20);
+    CHECK(n > 1);
+    // Each fragment alone yields exactly the world entities of its id range
+    for (std::size_t k = 0; k < n; ++k) {
+        StateDeltaHeader sh{};
+        World part;
+        CHECK(decodeFragment(frags[k], {}, sh, part));
+        World expected;
+        for (const PackedEntity& e : world)
+            if (e.id >= sh.firstId && e.id <= sh.lastId) expected.push_back(e);
+        CHECK(sameWorld(part, expected));
+    }
+}
+
+void testLossAndBudget() {
+    std::mt19937 rng(11);
+    std::uint32_t nextId = 1;
+    World world;
+    for (int i = 0; i < 200; ++i) world.push_back(randomEntity(rng, nextId++));
+
+    ClientReplication rep;
+    rep.setViewer(100.f, 300.f);
+    Client client;
+    std::vector<std::vector<char>> frags;
+    World got;
+    std::uint32_t snap = 0;
+    std::size_t decodedCount = 0;
+    // A busy world over a tight budget with a lossy link: every snapshot the
+    // client completes is well formed, sorted and only holds spawned ids
+    for (int t = 0; t < 300; ++t) {
+        step(world, rng, nextId);
+        ++snap;
+        const std::size_t n = rep.encode(snap, snap * 16, world, frags, 1200, 600);
+        std::size_t bytes = 0;
+        for (std::size_t k = 0; k < n; ++k) bytes += frags[k].size() - sizeof(StateDeltaHeader);
+        CHECK(bytes <= 600);
+        if (rng() % 100 < 25) continue; // a fragment of the snapshot got lost
+        if (!client.decode(frags, n, got)) continue;
+        ++decodedCount;
+        CHECK(std::is_sorted(got.begin(), got.end(), [](const PackedEntity& a, const PackedEntity& b) { return a.id < b.id; }));
+        CHECK(got.empty() || got.back().id < nextId);
+        if (rng() % 100 >= 25) rep.acknowledge(snap);
+    }
+    CHECK(decodedCount > 100);
+
+    // Once the world settles, the pending records drain and the client catches up
+    bool caughtUp = false;
+    for (int t = 0; t < 200 && !caughtUp; ++t) {
+        ++snap;
+        const std::size_t n = rep.encode(snap, snap * 16, world, frags, 1200, 600);
+        if (client.decode(frags, n, got)) {
+            rep.acknowledge(snap);
+            caughtUp = sameWorld(got, world);
+        }
+    }
+    CHECK(caughtUp);
+}
+
+}
+
+int main() {
+    testRoundTrip();
+    testFragmentsStandAlone();
+    testLossAndBudget();
+    return rtype::test::result();
+}